@@ -1,14 +1,44 @@
+#include <new>
 #include "arena.h"
+#include "mutexlock.h"
 
 namespace leveldb{
 
 static const int kBlockSize = 4096;
+//shardÿδhuge page blockµĴС
+static const size_t kShardBlockSize = 32 * 1024;
+//huge page blockС2MԱںʹ͸ҳٴmemtableTLB miss
+static const size_t kHugeBlockSize = 2 * 1024 * 1024;
 
-Arena::Arena()
+Arena::Arena(bool concurrent)
 {
-	blocks_memory_ = 0;
+	memory_usage_.NoBarrier_Store(0);
 	alloc_ptr_ = NULL;
 	alloc_bytes_remaining_ = 0;
+	huge_alloc_ptr_ = NULL;
+	huge_bytes_remaining_ = 0;
+	shards_memory_ = NULL;
+	shards_ = NULL;
+	shard_mask_ = 0;
+
+	if(!concurrent)
+		return;
+
+	//shardΪCPUȡ2
+	const int cpus = port::NumberOfCPUs();
+	int shards = 1;
+	while(shards < cpus && shards < 64)
+		shards <<= 1;
+
+	assert(sizeof(Shard) % kCacheLineSize == 0);
+	shards_memory_ = new char[shards * sizeof(Shard) + kCacheLineSize];
+	const size_t mod = reinterpret_cast<uintptr_t>(shards_memory_) & (kCacheLineSize - 1);
+	char* aligned = shards_memory_ + (mod == 0 ? 0 : kCacheLineSize - mod);
+
+	shards_ = reinterpret_cast<Shard*>(aligned);
+	for(int i = 0; i < shards; i ++)
+		new (&shards_[i]) Shard();
+	shard_mask_ = shards - 1;
 }
 
 Arena::~Arena()
@@ -16,6 +46,16 @@ Arena::~Arena()
 	for(size_t i = 0; i < blocks_.size(); i ++){
 		delete []blocks_[i];
 	}
+
+	for(size_t i = 0; i < huge_blocks_.size(); i ++){
+		port::FreeHugePageBlock(huge_blocks_[i]);
+	}
+
+	if(shards_ != NULL){
+		for(int i = 0; i <= shard_mask_; i ++)
+			shards_[i].~Shard();
+		delete []shards_memory_;
+	}
 }
 
 char* Arena::AllocateFallback(size_t bytes)
@@ -64,8 +104,79 @@ char* Arena::AllocateAligned(size_t bytes)
 char* Arena::AllocateNewBlock(size_t block_bytes)
 {
 	char* result = new char[block_bytes];
-	blocks_memory_ += block_bytes;
 	blocks_.push_back(result);
+	AddMemoryUsage(block_bytes + sizeof(char*));
+	return result;
+}
+
+//ֻгдȨ޵߳(д̻߳߳mutex_)޸ģ߳̿ʱȡ
+void Arena::AddMemoryUsage(size_t bytes)
+{
+	memory_usage_.NoBarrier_Store(reinterpret_cast<void*>(MemoryUsage() + bytes));
+}
+
+//huge page blockгbytesС߳mutex_
+//ڴռֻгȥĲ֣write_buffer_sizeСmemtableΪһhuge page blockͱΪд
+char* Arena::AllocateHugeChunk(size_t bytes)
+{
+	assert(bytes <= kHugeBlockSize);
+	if(bytes > huge_bytes_remaining_){
+		char* block = port::AllocateHugePageBlock(kHugeBlockSize);
+		huge_blocks_.push_back(block);
+		AddMemoryUsage(sizeof(char*));
+
+		huge_alloc_ptr_ = block;
+		huge_bytes_remaining_ = kHugeBlockSize;
+	}
+
+	char* result = huge_alloc_ptr_;
+	huge_alloc_ptr_ += bytes;
+	huge_bytes_remaining_ -= bytes;
+	AddMemoryUsage(bytes);
+	return result;
+}
+
+char* Arena::AllocateFromShard(size_t bytes, bool aligned)
+{
+	assert(bytes > 0);
+
+	//ڴûдshardʱֱӴarena
+	if(bytes > kShardBlockSize / 4 || shards_ == NULL){
+		MutexLock l(&mutex_);
+		return aligned ? AllocateAligned(bytes) : Allocate(bytes);
+	}
+
+	//ǰ߳ڵCPUѡshard
+	int cpu = port::PhysicalCoreID();
+	if(cpu < 0){ //ֻ֧ȡCPUţ߳ջַɢ
+		cpu = static_cast<int>(reinterpret_cast<uintptr_t>(&cpu) >> 12);
+	}
+
+	Shard* shard = &shards_[cpu & shard_mask_];
+	MutexLock l(&shard->mu);
+
+	const int align = (sizeof(void*) > 8) ? sizeof(void *) : 8;
+	size_t slop = 0;
+	if(aligned){
+		size_t current_mod = reinterpret_cast<uintptr_t>(shard->free_begin) & (align - 1);
+		slop = (current_mod == 0 ? 0 : align - current_mod);
+	}
+
+	if(bytes + slop > shard->remaining){
+		//shardʣµĿռ䶪huge page blockһ
+		{
+			MutexLock al(&mutex_);
+			shard->free_begin = AllocateHugeChunk(kShardBlockSize);
+		}
+		shard->remaining = kShardBlockSize;
+		slop = 0;
+	}
+
+	char* result = shard->free_begin + slop;
+	shard->free_begin += bytes + slop;
+	shard->remaining -= bytes + slop;
+
+	assert(!aligned || (reinterpret_cast<uintptr_t>(result) & (align - 1)) == 0);
 	return result;
 }
 
@@ -5,26 +5,38 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include "port.h"
 
 namespace leveldb {
 
 class Arena
 {
 public:
-	Arena();
+	//concurrentΪtrueʱŴÿCPU˵ķshardAllocateConcurrentֻ
+	explicit Arena(bool concurrent = false);
 	~Arena();
 
 	char* Allocate(size_t bytes);
 	char* AllocateAligned(size_t bytes);
 
+	//̰߳ȫķӿڣ̲߳memtableʱʹá
+	//ÿCPU˶ӦһshardshardӶ뵽huge pageĴڴгСз䣬
+	//ͬϵд֮߳ûûдshardʱ˻Ϊmutex_·
+	char* AllocateConcurrent(size_t bytes) { return AllocateFromShard(bytes, false); };
+	char* AllocateAlignedConcurrent(size_t bytes) { return AllocateFromShard(bytes, true); };
+
+	//߳дʱȡ
 	size_t MemoryUsage() const
 	{
-		return blocks_memory_ + blocks_.capacity() * sizeof(char *);
+		return reinterpret_cast<uintptr_t>(memory_usage_.NoBarrier_Load());
 	};
 
 private:
 	char* AllocateFallback(size_t bytes);
 	char* AllocateNewBlock(size_t block_bytes);
+	char* AllocateFromShard(size_t bytes, bool aligned);
+	char* AllocateHugeChunk(size_t bytes);
+	void AddMemoryUsage(size_t bytes);
 
 	Arena(const Arena&);
 	void operator=(const Arena&);
@@ -34,7 +46,36 @@ private:
 	size_t alloc_bytes_remaining_;
 
 	std::vector<char*> blocks_;
-	size_t blocks_memory_;
+
+	//ܵڴռãAtomicPointerԱ߳ȡ
+	port::AtomicPointer memory_usage_;
+
+	enum { kCacheLineSize = 64 };
+
+	//ÿCPUһshard뵽cache line
+	//ʼַҲcache line룬ͬshardͬһcache lineϲfalse sharing
+	struct Shard
+	{
+		port::Mutex mu;
+		char* free_begin;
+		size_t remaining;
+		char padding[kCacheLineSize - (sizeof(port::Mutex) + sizeof(char*) + sizeof(size_t)) % kCacheLineSize];
+
+		Shard() : free_begin(NULL), remaining(0){};
+	};
+
+	//shards_ڵԭʼڴ棬һcache lineڶ
+	char* shards_memory_;
+	Shard* shards_;
+	int shard_mask_;
+
+	//huge pageĴڴ棬ڸshardз
+	std::vector<char*> huge_blocks_;
+	char* huge_alloc_ptr_;
+	size_t huge_bytes_remaining_;
+
+	//ʱblocks_huge_blocks_ķ
+	port::Mutex mutex_;
 };
 
 //Arenaеõһڴ
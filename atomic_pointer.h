@@ -59,6 +59,41 @@ inline void MemoryBarrier() {
 
 #endif
 
+//ԭӱȽϽ*ptr == old_valueʱ滻new_valuetrue
+inline bool AtomicCompareAndSwap(void** ptr, void* old_value, void* new_value) {
+#if defined(OS_WIN) && defined(COMPILER_MSVC)
+	return InterlockedCompareExchangePointer(ptr, new_value, old_value) == old_value;
+#else
+	return __sync_bool_compare_and_swap(ptr, old_value, new_value);
+#endif
+}
+
+//ԭӼӣؼ֮ǰֵ
+inline intptr_t AtomicFetchAdd(volatile intptr_t* ptr, intptr_t delta) {
+#if defined(OS_WIN) && defined(COMPILER_MSVC)
+#if defined(_WIN64)
+	return InterlockedExchangeAdd64(reinterpret_cast<volatile LONGLONG*>(ptr), delta);
+#else
+	return InterlockedExchangeAdd(reinterpret_cast<volatile LONG*>(ptr), delta);
+#endif
+#else
+	return __sync_fetch_and_add(ptr, delta);
+#endif
+}
+
+//汾ԭӱȽϽ
+inline bool AtomicCompareAndSwapWord(volatile intptr_t* ptr, intptr_t old_value, intptr_t new_value) {
+#if defined(OS_WIN) && defined(COMPILER_MSVC)
+#if defined(_WIN64)
+	return InterlockedCompareExchange64(reinterpret_cast<volatile LONGLONG*>(ptr), new_value, old_value) == old_value;
+#else
+	return InterlockedCompareExchange(reinterpret_cast<volatile LONG*>(ptr), new_value, old_value) == old_value;
+#endif
+#else
+	return __sync_bool_compare_and_swap(ptr, old_value, new_value);
+#endif
+}
+
 // AtomicPointer built using platform-specific MemoryBarrier()
 #if defined(LEVELDB_HAVE_MEMORY_BARRIER)
 class AtomicPointer {
@@ -78,6 +113,9 @@ public:
 		MemoryBarrier();
 		rep_ = v;
 	}
+	inline bool CompareAndSwap(void* old_value, void* new_value) {
+		return AtomicCompareAndSwap(&rep_, old_value, new_value);
+	}
 };
 
 // AtomicPointer based on <cstdatomic>
@@ -100,6 +138,9 @@ public:
 	inline void NoBarrier_Store(void* v) {
 		rep_.store(v, std::memory_order_relaxed);
 	}
+	inline bool CompareAndSwap(void* old_value, void* new_value) {
+		return rep_.compare_exchange_strong(old_value, new_value);
+	}
 };
 
 // Atomic pointer based on sparc memory barriers
@@ -130,6 +171,9 @@ public:
 	}
 	inline void* NoBarrier_Load() const { return rep_; }
 	inline void NoBarrier_Store(void* v) { rep_ = v; }
+	inline bool CompareAndSwap(void* old_value, void* new_value) {
+		return AtomicCompareAndSwap(&rep_, old_value, new_value);
+	}
 };
 
 // Atomic pointer based on ia64 acq/rel
@@ -160,6 +204,9 @@ public:
 	}
 	inline void* NoBarrier_Load() const { return rep_; }
 	inline void NoBarrier_Store(void* v) { rep_ = v; }
+	inline bool CompareAndSwap(void* old_value, void* new_value) {
+		return AtomicCompareAndSwap(&rep_, old_value, new_value);
+	}
 };
 
 // We have neither MemoryBarrier(), nor <cstdatomic>
@@ -1,6 +1,12 @@
 #include "filter_policy.h"
 #include "slice.h"
 #include "hash.h"
+#include "port.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LEVELDB_BLOOM_AVX2
+#endif
 
 namespace leveldb{
 namespace {
@@ -87,12 +93,249 @@ private:
 	size_t k_;
 };
 
+//cache lineֿbloom
+//洢ṹ|line 0(64ֽ)|line 1|...|line n-1|k(1ֽ)|
+//keyhashλѡlinekbitlineڣ̽ʱֻһ64ֽڵĿ
+static const size_t kBloomCacheLineSize = 64;
+static const uint32_t kBloomCacheLineBits = kBloomCacheLineSize * 8;
+
+//jbitlineڵλmultiply-shift㣺(g * kBloomMultipliers[j % 8]) >> 23ȡ˻ĸ9λ
+//ÿ8bitһ飬֮RehashGroup´ɢglinehashĸλѡghashѭλõ
+//˷ÿλögbitѡlineѡbitõͬһhash
+static const uint32_t kBloomMultipliers[8] = {
+	0x9e3779b9u, 0x85ebca6bu, 0xc2b2ae35u, 0x27d4eb2fu,
+	0x165667b1u, 0x94d049bbu, 0xbf58476du, 0x2545f491u
+};
+
+static inline uint32_t RehashGroup(uint32_t g)
+{
+	return (g ^ (g >> 15)) * 0x2c1b3c6du;
+}
+
+typedef bool (*BloomProbeFunc)(const char* line, uint32_t g, size_t k);
+typedef void (*BloomAddFunc)(char* line, uint32_t g, size_t k);
+
+static bool ProbeLineScalar(const char* line, uint32_t g, size_t k)
+{
+	for(size_t j = 0; j < k; j ++){
+		if(j > 0 && (j & 7) == 0)
+			g = RehashGroup(g);
+
+		const uint32_t bitpos = (g * kBloomMultipliers[j & 7]) >> 23;
+		if((line[bitpos / 8] & (1 << (bitpos % 8))) == 0)
+			return false;
+	}
+	return true;
+}
+
+static void AddLineScalar(char* line, uint32_t g, size_t k)
+{
+	for(size_t j = 0; j < k; j ++){
+		if(j > 0 && (j & 7) == 0)
+			g = RehashGroup(g);
+
+		const uint32_t bitpos = (g * kBloomMultipliers[j & 7]) >> 23;
+		line[bitpos / 8] |= (1 << (bitpos % 8));
+	}
+}
+
+#ifdef LEVELDB_BLOOM_AVX2
+//һ8λһ_mm256_mullo_epi32bitpos >> 5lineڵ32λ±꣬1 << (bitpos & 31)ڵ룬
+//Сºͱ汾ֽѰַĽȫһ£ʵɵĹԻȡ
+__attribute__((target("avx2")))
+static bool ProbeLineAVX2(const char* line, uint32_t g, size_t k)
+{
+	const __m256i multipliers = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kBloomMultipliers));
+	const __m256i bit_mask = _mm256_set1_epi32(31);
+	const __m256i one = _mm256_set1_epi32(1);
+
+	for(size_t j = 0; j < k; j += 8){
+		if(j > 0)
+			g = RehashGroup(g);
+
+		const __m256i bitpos = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(g)), multipliers), 23);
+		const __m256i word = _mm256_srli_epi32(bitpos, 5);
+		const __m256i mask = _mm256_sllv_epi32(one, _mm256_and_si256(bitpos, bit_mask));
+		const __m256i data = _mm256_i32gather_epi32(reinterpret_cast<const int*>(line), word, 4);
+		const __m256i hit = _mm256_cmpeq_epi32(_mm256_and_si256(data, mask), mask);
+
+		//һ鲻8ʱֻǰk - j
+		const size_t valid = (k - j < 8) ? (k - j) : 8;
+		const int want = (1 << valid) - 1;
+		if((_mm256_movemask_ps(_mm256_castsi256_ps(hit)) & want) != want)
+			return false;
+	}
+	return true;
+}
+
+//λõļλдͻ(λÿͬһֽ)
+__attribute__((target("avx2")))
+static void AddLineAVX2(char* line, uint32_t g, size_t k)
+{
+	const __m256i multipliers = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kBloomMultipliers));
+
+	uint32_t bitpos[8];
+	for(size_t j = 0; j < k; j += 8){
+		if(j > 0)
+			g = RehashGroup(g);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(bitpos), _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(g)), multipliers), 23));
+		const size_t valid = (k - j < 8) ? (k - j) : 8;
+		for(size_t i = 0; i < valid; i ++)
+			line[bitpos[i] / 8] |= (1 << (bitpos[i] % 8));
+	}
+}
+#endif
+
+static inline void PrefetchLine(const char* line)
+{
+#if defined(__GNUC__)
+	__builtin_prefetch(line, 0, 3);
+#endif
+}
+
+class BlockedBloomFilterPolicy : public FilterPolicy
+{
+public:
+	//hash64ΪtrueʱHash6432λѡline32λlineڵλ
+	BlockedBloomFilterPolicy(int bits_per_key, bool hash64)
+		: bits_per_key_(bits_per_key), hash64_(hash64), probe_(ProbeLineScalar), add_(AddLineScalar)
+	{
+		k_ = static_cast<size_t>(bits_per_key * 0.69);
+		if(k_ < 1)
+			k_ = 1;
+		else if(k_ > 30)
+			k_ = 30;
+
+		//ڹʱCPUѡһʵ֣֮ĵûз֧
+#ifdef LEVELDB_BLOOM_AVX2
+		if(port::HasAVX2()){
+			probe_ = ProbeLineAVX2;
+			add_ = AddLineAVX2;
+		}
+#endif
+	}
+
+	virtual const char* name() const
+	{
+		return hash64_ ? "leveldb.BlockedBloomFilter64" : "leveldb.BlockedBloomFilter";
+	}
+
+	virtual void CreateFilter(const Slice* keys, int n, std::string* dst) const
+	{
+		size_t num_lines = (n * bits_per_key_ + kBloomCacheLineBits - 1) / kBloomCacheLineBits;
+		if(num_lines == 0)
+			num_lines = 1;
+
+		const size_t init_size = dst->size();
+		dst->resize(init_size + num_lines * kBloomCacheLineSize, 0);
+		dst->push_back(static_cast<char>(k_));
+
+		char* array = &(*dst)[init_size];
+		for(int i = 0; i < n; i ++){
+			uint32_t g;
+			const size_t line = FindLine(keys[i], num_lines, &g);
+			add_(array + line * kBloomCacheLineSize, g, k_);
+		}
+	}
+
+	virtual bool KeyMayMatch(const Slice& key, const Slice& bloom_filter) const
+	{
+		size_t num_lines, k;
+		if(!ParseFilter(bloom_filter, &num_lines, &k))
+			return true;
+
+		uint32_t g;
+		const size_t line = FindLine(key, num_lines, &g);
+		return probe_(bloom_filter.data() + line * kBloomCacheLineSize, g, k);
+	}
+
+	//һkeyhashlineԤȡ̽⣬
+	//CPU cacheʱkeycache missص
+	virtual void KeysMayMatch(const Slice* keys, int n, const Slice& bloom_filter, bool* results) const
+	{
+		size_t num_lines, k;
+		if(!ParseFilter(bloom_filter, &num_lines, &k)){
+			for(int i = 0; i < n; i ++)
+				results[i] = true;
+			return;
+		}
+
+		const char* array = bloom_filter.data();
+		uint32_t probes[kBatchSize];
+		const char* lines[kBatchSize];
+		for(int start = 0; start < n; start += kBatchSize){
+			const int count = (n - start < kBatchSize) ? (n - start) : kBatchSize;
+			for(int i = 0; i < count; i ++){
+				lines[i] = array + FindLine(keys[start + i], num_lines, &probes[i]) * kBloomCacheLineSize;
+				PrefetchLine(lines[i]);
+			}
+
+			for(int i = 0; i < count; i ++){
+				results[start + i] = probe_(lines[i], probes[i], k);
+			}
+		}
+	}
+
+private:
+	enum { kBatchSize = 32 };
+
+	//ó˷λhashӳ䵽[0, num_lines)ȡģ
+	static size_t LineIndex(uint32_t h, size_t num_lines)
+	{
+		return static_cast<size_t>((static_cast<uint64_t>(h) * num_lines) >> 32);
+	}
+
+	//keyڵline*gΪline̽λõʼֵ
+	size_t FindLine(const Slice& key, size_t num_lines, uint32_t* g) const
+	{
+		if(hash64_){
+			const uint64_t h = Hash64(key.data(), key.size(), 0xbc9f1d34);
+			*g = static_cast<uint32_t>(h);
+			return LineIndex(static_cast<uint32_t>(h >> 32), num_lines);
+		}
+
+		const uint32_t h = BloomHash(key);
+		*g = (h >> 17) | (h << 15);
+		return LineIndex(h, num_lines);
+	}
+
+	//ʽԻǲʶıʱfalseߵܴ
+	static bool ParseFilter(const Slice& bloom_filter, size_t* num_lines, size_t* k)
+	{
+		const size_t len = bloom_filter.size();
+		if(len < kBloomCacheLineSize + 1 || (len - 1) % kBloomCacheLineSize != 0)
+			return false;
+
+		*num_lines = (len - 1) / kBloomCacheLineSize;
+		*k = static_cast<unsigned char>(bloom_filter[len - 1]);
+		return *k <= 30; //ֵµı뷽ʽ
+	}
+
+private:
+	size_t bits_per_key_;
+	size_t k_;
+	bool hash64_;
+	BloomProbeFunc probe_;
+	BloomAddFunc add_;
+};
+
 //һbloomʵ
 const FilterPolicy* NewBloomFilterPolicy(int bits_per_key)
 {
 	return new BloomFilterPolicy(bits_per_key);
 }
 
+const FilterPolicy* NewBlockedBloomFilterPolicy(int bits_per_key)
+{
+	return new BlockedBloomFilterPolicy(bits_per_key, false);
+}
+
+const FilterPolicy* NewBlockedBloomFilterPolicy64(int bits_per_key)
+{
+	return new BlockedBloomFilterPolicy(bits_per_key, true);
+}
+
 };
 
 
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "filter_policy.h"
+#include "slice.h"
+#include "coding.h"
+
+//bloomʼ飬ģ飬У
+//g++ -DLEVELDB_PLATFORM_POSIX bloom_test.cc bloom.cc hash.cc coding.cc port_posix.cc -lpthread -o bloom_test
+namespace leveldb{
+
+static Slice Key(uint32_t i, char* buffer)
+{
+	EncodeFixed32(buffer, i);
+	return Slice(buffer, sizeof(uint32_t));
+}
+
+//nkeykeyУnڼеkeyͳ
+static bool CheckFalsePositiveRate(const FilterPolicy* policy, int n, double max_rate)
+{
+	std::vector<std::string> key_storage(n);
+	std::vector<Slice> keys(n);
+	char buffer[sizeof(uint32_t)];
+	for(int i = 0; i < n; i ++){
+		key_storage[i] = Key(i, buffer).ToString();
+		keys[i] = Slice(key_storage[i]);
+	}
+
+	std::string filter;
+	policy->CreateFilter(&keys[0], n, &filter);
+
+	for(int i = 0; i < n; i ++){
+		if(!policy->KeyMayMatch(keys[i], filter)){
+			fprintf(stderr, "%s: n = %d, key %d missing\n", policy->name(), n, i);
+			return false;
+		}
+	}
+
+	int false_positives = 0;
+	for(int i = 0; i < n; i ++){
+		if(policy->KeyMayMatch(Key(i + 1000000000, buffer), filter))
+			false_positives ++;
+	}
+
+	const double rate = static_cast<double>(false_positives) / n;
+	fprintf(stderr, "%s: n = %d, bytes = %d, false positives = %5.2f%%\n", 
+		policy->name(), n, static_cast<int>(filter.size()), rate * 100.0);
+
+	return rate <= max_rate;
+}
+
+//KeysMayMatch̽ĽKeyMayMatchȫһ
+static bool CheckBatchMatchesSingle(const FilterPolicy* policy, int n)
+{
+	std::vector<std::string> key_storage(n);
+	std::vector<Slice> keys(n);
+	char buffer[sizeof(uint32_t)];
+	for(int i = 0; i < n; i ++){
+		key_storage[i] = Key(i, buffer).ToString();
+		keys[i] = Slice(key_storage[i]);
+	}
+
+	std::string filter;
+	policy->CreateFilter(&keys[0], n, &filter);
+
+	//һڼУһ벻
+	std::vector<std::string> probe_storage(2 * n);
+	std::vector<Slice> probes(2 * n);
+	for(int i = 0; i < 2 * n; i ++){
+		probe_storage[i] = Key(i < n ? i : i + 1000000000, buffer).ToString();
+		probes[i] = Slice(probe_storage[i]);
+	}
+
+	bool* results = new bool[2 * n];
+	policy->KeysMayMatch(&probes[0], 2 * n, filter, results);
+
+	bool ok = true;
+	for(int i = 0; i < 2 * n; i ++){
+		if(results[i] != policy->KeyMayMatch(probes[i], filter)){
+			fprintf(stderr, "%s: n = %d, batch result of probe %d differs\n", policy->name(), n, i);
+			ok = false;
+			break;
+		}
+	}
+
+	delete []results;
+	return ok;
+}
+
+};//leveldb
+
+int main(int argc, char** argv)
+{
+	bool ok = true;
+
+	//10 bits/keyʱ׼bloomԼΪ1%ֿʵΪline֮为زԸһЩ
+	const leveldb::FilterPolicy* blocked = leveldb::NewBlockedBloomFilterPolicy(10);
+	const int lengths[] = {1000, 10000, 100000, 1000000};
+	for(size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i ++){
+		if(!leveldb::CheckFalsePositiveRate(blocked, lengths[i], 0.02))
+			ok = false;
+		if(!leveldb::CheckBatchMatchesSingle(blocked, lengths[i]))
+			ok = false;
+	}
+	delete blocked;
+
+	fprintf(stderr, ok ? "PASS\n" : "FAIL\n");
+	return ok ? 0 : 1;
+}
@@ -25,8 +25,12 @@ Status BuilderTable(const std::string& dbname, Env* env, const Options& opt, Tab
 		if(!s.ok())
 			return s;
 
+		//level 0ļĴСӽmemtableĴСһԤ
+		file->SetPreallocationBlockSize(opt.write_buffer_size + opt.write_buffer_size / 10);
+		file->SetBytesPerSync(opt.bytes_per_sync);
+
 		//һtable builder
-		TableBuilder* builder = new TableBuilder(opt, file);
+		TableBuilder* builder = new TableBuilder(opt, file, 0);
 		//ȷСkey
 		meta->smallest.DecodeFrom(iter->key());
 		for(; iter->Valid(); iter->Next()){
@@ -62,7 +66,8 @@ Status BuilderTable(const std::string& dbname, Env* env, const Options& opt, Tab
 
 		if(s.ok()){
 			//УtableǷ
-			Iterator* it = table_cache->NewIterator(ReadOptions(), meta->number, meta->file_size);
+			//memtableдlevel 0
+			Iterator* it = table_cache->NewIterator(ReadOptions(), meta->number, meta->file_size, NULL, 0);
 			s = it->status();
 			delete it;
 		}
@@ -14,14 +14,15 @@ namespace{
 struct LRUHandle
 {
 	void* value;
-	void (deleter)(const Slice& key, void* value);
+	void (*deleter)(const Slice& key, void* value);
 	LRUHandle* next_hash;
 	LRUHandle* next;
 	LRUHandle* prev;
 	size_t charge;		
 	size_t key_length;	//keyĳ
 	uint32_t refs;		//ü
-	uint32_t hash;		//keyHASH
+	uint64_t hash;		//keyHASH
+	bool in_high_pri_pool; //Ƿڱ
 	char key_data[1];	//KEYʼλ
 
 	Slice key() const
@@ -49,7 +50,7 @@ public:
 		delete []list_;
 	}
 
-	LRUHandle* Lookup(const Slice& key, uint32_t hash)
+	LRUHandle* Lookup(const Slice& key, uint64_t hash)
 	{
 		return *FindPointer(key, hash);
 	}
@@ -71,7 +72,7 @@ public:
 		return old;
 	}
 
-	LRUHandle* Remove(const Slice& key, uint32_t hash)
+	LRUHandle* Remove(const Slice& key, uint64_t hash)
 	{
 		LRUHandle** ptr = FindPointer(key, hash);
 		LRUHandle* result = *ptr;
@@ -84,7 +85,7 @@ public:
 	}
 
 private:
-	LRUHandle** FindPointer(const Slice& key, uint32_t hash)
+	LRUHandle** FindPointer(const Slice& key, uint64_t hash)
 	{
 		LRUHandle** ptr = &list_[hash & (length_ - 1)];
 		while(*ptr != NULL && ((*ptr)->hash != hash || key != (*ptr)->key())){ //ǷѾhashhandleڣֱӷʼλ
@@ -111,7 +112,7 @@ private:
 			while(h != NULL){
 				//h״̬
 				LRUHandle* next = h->next_hash;
-				uint32_t hash = h->hash;
+				uint64_t hash = h->hash;
 				//new listλ
 				LRUHandle** ptr = &new_list[hash & (new_length - 1)];
 				//뵽Ӧλõʼ
@@ -143,36 +144,49 @@ public:
 	LRUCache();
 	~LRUCache();
 
-	void SetCapacity(size_t capacity) 
+	void SetCapacity(size_t capacity, double high_pri_pool_ratio) 
 	{
 		capacity_ = capacity;
+		high_pri_pool_capacity_ = static_cast<size_t>(capacity * high_pri_pool_ratio);
 	}
 
-	Cache::Handle* Insert(const Slice& key, uint32_t hash, void* value, size_t charge, void (*deleter)(const Slice& key, void* v));
-	Cache::Handle* Lookup(const Slice& key, uint32_t hash);
+	Cache::Handle* Insert(const Slice& key, uint64_t hash, void* value, size_t charge, void (*deleter)(const Slice& key, void* v), Cache::Priority priority);
+	Cache::Handle* Lookup(const Slice& key, uint64_t hash);
 	void Release(Cache::Handle* handle);
-	void Erase(const Slice& key, uint32_t hash);
+	void Erase(const Slice& key, uint64_t hash);
+
+	static uint64_t HandleHash(Cache::Handle* handle) { return reinterpret_cast<LRUHandle*>(handle)->hash; };
+	static void* HandleValue(Cache::Handle* handle) { return reinterpret_cast<LRUHandle*>(handle)->value; };
 
 private:
 	void LRU_Remove(LRUHandle* e);
-	void LRU_Append(LRUHandle* e);
+	void LRU_Append(LRUHandle* e, bool high_pri);
+	void MaintainPoolSize();
 	void Unref(LRUHandle* e);
 
 private:
 	size_t capacity_;
+	//ε
+	size_t high_pri_pool_capacity_;
 
 	port::Mutex mutex_;
 	size_t usage_;
+	size_t high_pri_pool_usage_;
 
+	//öΣlru_.nextϵentry̭
 	LRUHandle lru_;
+	//Σйentry͸ȼentry
+	LRUHandle high_pri_lru_;
 
 	HandleTable table_;
 };
 
-LRUCache::LRUCache() : usage_(0)
+LRUCache::LRUCache() : capacity_(0), high_pri_pool_capacity_(0), usage_(0), high_pri_pool_usage_(0)
 {
 	lru_.next = &lru_;
 	lru_.prev = &lru_;
+	high_pri_lru_.next = &high_pri_lru_;
+	high_pri_lru_.prev = &high_pri_lru_;
 }
 
 LRUCache::~LRUCache()
@@ -183,6 +197,13 @@ LRUCache::~LRUCache()
 		Unref(e);
 		e = next;
 	}
+
+	for(LRUHandle* e = high_pri_lru_.next; e != &high_pri_lru_; ){
+		LRUHandle* next = e->next;
+		assert(e->refs == 1);
+		Unref(e);
+		e = next;
+	}
 }
 
 void LRUCache::Unref(LRUHandle* e)
@@ -200,24 +221,49 @@ void LRUCache::LRU_Remove(LRUHandle* e)
 {
 	e->next->prev = e->prev;
 	e->prev->next = e->next;
+	if(e->in_high_pri_pool){
+		assert(high_pri_pool_usage_ >= e->charge);
+		high_pri_pool_usage_ -= e->charge;
+		e->in_high_pri_pool = false;
+	}
 }
 
-void LRUCache::LRU_Append(LRUHandle* e)
+//Ϊµentry뱣λö
+void LRUCache::LRU_Append(LRUHandle* e, bool high_pri)
 {
-	e->next = &lru_;
-	e->prev = lru_.prev;
+	LRUHandle* list = &lru_;
+	if(high_pri && high_pri_pool_capacity_ > 0){
+		list = &high_pri_lru_;
+		e->in_high_pri_pool = true;
+		high_pri_pool_usage_ += e->charge;
+	}
+
+	e->next = list;
+	e->prev = list->prev;
 	e->prev->next = e;
 	e->next->prev = e;
 }
 
-Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash)
+//γʱϵentryΪöµentry
+void LRUCache::MaintainPoolSize()
+{
+	while(high_pri_pool_usage_ > high_pri_pool_capacity_ && high_pri_lru_.next != &high_pri_lru_){
+		LRUHandle* e = high_pri_lru_.next;
+		LRU_Remove(e);
+		LRU_Append(e, false);
+	}
+}
+
+Cache::Handle* LRUCache::Lookup(const Slice& key, uint64_t hash)
 {
 	MutexLock l(&mutex_);
 	LRUHandle* e = table_.Lookup(key, hash);
 	if(e != NULL){
 		e->refs ++;
+		//ٴУ
 		LRU_Remove(e);
-		LRU_Append(e);
+		LRU_Append(e, true);
+		MaintainPoolSize();
 	}
 
 	return reinterpret_cast<Cache::Handle*>(e);
@@ -229,7 +275,7 @@ void LRUCache::Release(Cache::Handle* handle)
 	Unref(reinterpret_cast<LRUHandle *>(handle));
 }
 
-Cache::Handle* LRUCache::Insert(const Slice& key, uint32_t hash, void* value, size_t charge, void (*deleter)(const Slice& key, void* v))
+Cache::Handle* LRUCache::Insert(const Slice& key, uint64_t hash, void* value, size_t charge, void (*deleter)(const Slice& key, void* v), Cache::Priority priority)
 {
 	MutexLock l(&mutex_);
 	//1LRUHandle::key_data[1]1ֽڵĿռ
@@ -239,10 +285,13 @@ Cache::Handle* LRUCache::Insert(const Slice& key, uint32_t hash, void* value, si
 	e->charge = charge;
 	e->key_length = key.size();
 	e->hash = hash;
+	e->in_high_pri_pool = false;
 	//LRUCahceӦ1Σreturn eҲ1
 	e->refs = 2;
 	memcpy(e->key_data, key.data(), key.size());
-	LRU_Append(e);
+	//ȼentryȽöΣȼֱӽ뱣
+	LRU_Append(e, priority == Cache::HIGH);
+	MaintainPoolSize();
 	usage_ += charge;
 
 	//ɾûhandle
@@ -252,9 +301,9 @@ Cache::Handle* LRUCache::Insert(const Slice& key, uint32_t hash, void* value, si
 		Unref(old);
 	}
 
-	//Сжϣ꣬ɾ
-	while(usage_ > capacity_ && lru_.next != &lru_){
-		LRUHandle* old = lru_.next;
+	//Сжϣ̭꣬öΣ̭
+	while(usage_ > capacity_ && (lru_.next != &lru_ || high_pri_lru_.next != &high_pri_lru_)){
+		LRUHandle* old = (lru_.next != &lru_) ? lru_.next : high_pri_lru_.next;
 		LRU_Remove(old);
 		table_.Remove(old->key(), old->hash);
 		Unref(old);
@@ -263,7 +312,7 @@ Cache::Handle* LRUCache::Insert(const Slice& key, uint32_t hash, void* value, si
 	return reinterpret_cast<Cache::Handle*>(e);
 }
 
-void LRUCache::Erase(const Slice& key, uint32_t hash)
+void LRUCache::Erase(const Slice& key, uint64_t hash)
 {
 	MutexLock l(&mutex_);
 	LRUHandle* e = table_.Remove(key, hash);
@@ -273,50 +322,369 @@ void LRUCache::Erase(const Slice& key, uint32_t hash)
 	}
 }
 
-static const int kNumShardBits = 4;
-static const int kNumShards = 1 << kNumShardBits;
+//clock cacheslot״̬ClockHandle::metaĸλλⲿü
+enum ClockSlotState
+{
+	kSlotEmpty			= 0,	//
+	kSlotConstruction	= 1,	//ĳ̶߳ռͷ
+	kSlotVisible		= 2,	//tableУԱLookup
+	kSlotInvisible		= 3		//ѾErase滻һͷź
+};
+
+static const int kClockStateShift = 28;
+static const intptr_t kClockRefsMask = (static_cast<intptr_t>(1) << kClockStateShift) - 1;
 
-class ShardedLRUCache : public Cache
+static inline intptr_t ClockMeta(int state, intptr_t refs)
+{
+	return (static_cast<intptr_t>(state) << kClockStateShift) | refs;
+}
+
+static inline int ClockState(intptr_t meta)
+{
+	return static_cast<int>(meta >> kClockStateShift);
+}
+
+//clock cacheslotslotڹʱһη䣬ڲͷţ
+//LookupԲȶmetaԭӼãټ״̬key
+struct ClockHandle
+{
+	volatile intptr_t meta;				//״̬ + ü
+	volatile intptr_t displacements;	//̽оslotentryΪ0ʱLookupǰ
+	volatile intptr_t usage;			//clockλʱ1̭ɨʱ0
+	void* value;
+	void (*deleter)(const Slice& key, void* value);
+	char* key_data;
+	size_t key_length;
+	size_t charge;
+	uint64_t hash;
+	bool detached;						//tableʱ䡢tableеhandle
+
+	Slice key() const
+	{
+		return Slice(key_data, key_length);
+	}
+};
+
+//CLOCKûcache shardLookupкReleaseֻԭӲ
+//InsertErasḙɨmutex_л
+class ClockCache
 {
 public:
-	explicit ShardedLRUCache(size_t capacity) : last_id_(0)
+	ClockCache();
+	~ClockCache();
+
+	//slot飬estimated_entry_chargeentry
+	void SetCapacity(size_t capacity, size_t estimated_entry_charge);
+
+	Cache::Handle* Insert(const Slice& key, uint64_t hash, void* value, size_t charge, void (*deleter)(const Slice& key, void* v), Cache::Priority priority);
+	Cache::Handle* Lookup(const Slice& key, uint64_t hash);
+	void Release(Cache::Handle* handle);
+	void Erase(const Slice& key, uint64_t hash);
+
+	static uint64_t HandleHash(Cache::Handle* handle) { return reinterpret_cast<ClockHandle*>(handle)->hash; };
+	static void* HandleValue(Cache::Handle* handle) { return reinterpret_cast<ClockHandle*>(handle)->value; };
+
+private:
+	//Ѱַ̽ⲽȡ֤Ա2ݳȵ顣ʼλhashĵλø32λ
+	static uint32_t ProbeIncrement(uint64_t hash)
 	{
-		//ÿһshardcapacity
-		const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
-		for(int s = 0; s < kNumShards; s ++){
-			shard_[s].SetCapacity(per_shard);
+		return static_cast<uint32_t>(hash >> 32) | 1;
+	}
+
+	void Unref(ClockHandle* h);
+	void FreeSlot(ClockHandle* h);
+	ClockHandle* ClaimSlot(uint64_t hash);
+	void EraseLocked(const Slice& key, uint64_t hash);
+	bool EvictOne();
+
+private:
+	size_t capacity_;
+	uint32_t mask_;
+	size_t max_occupancy_;
+	ClockHandle* slots_;
+
+	port::Mutex mutex_;
+	uint32_t clock_hand_;
+
+	volatile intptr_t usage_;
+	volatile intptr_t occupancy_;
+};
+
+ClockCache::ClockCache() : capacity_(0), mask_(0), max_occupancy_(0), slots_(NULL), clock_hand_(0), usage_(0), occupancy_(0)
+{
+}
+
+ClockCache::~ClockCache()
+{
+	for(uint32_t i = 0; slots_ != NULL && i <= mask_; i ++){
+		ClockHandle* h = &slots_[i];
+		assert(ClockState(h->meta) == kSlotEmpty || ClockState(h->meta) == kSlotVisible);
+		assert((h->meta & kClockRefsMask) == 0);
+		if(ClockState(h->meta) == kSlotVisible){
+			(h->deleter)(h->key(), h->value);
+			free(h->key_data);
 		}
 	}
+	delete []slots_;
+}
 
-	virtual ~ShardedLRUCache(){};
+void ClockCache::SetCapacity(size_t capacity, size_t estimated_entry_charge)
+{
+	assert(slots_ == NULL);
+	if(estimated_entry_charge == 0)
+		estimated_entry_charge = 1;
+
+	//װӿ3/4
+	size_t estimated_entries = capacity / estimated_entry_charge + 1;
+	uint32_t length = 64;
+	while(length < estimated_entries * 4 / 3 && length < (1u << 30))
+		length *= 2;
+
+	capacity_ = capacity;
+	mask_ = length - 1;
+	max_occupancy_ = length * 3 / 4;
+	slots_ = new ClockHandle[length];
+	memset(slots_, 0x00, sizeof(ClockHandle) * length);
+}
+
+//ͷһãentryѾEraseһãslot
+void ClockCache::Unref(ClockHandle* h)
+{
+	intptr_t old = port::AtomicFetchAdd(&h->meta, -1);
+	assert((old & kClockRefsMask) > 0);
+	if(ClockState(old) == kSlotInvisible && (old & kClockRefsMask) == 1){
+		//LookupʱãCASʧʱǸ̵߳Unref
+		if(port::AtomicCompareAndSwapWord(&h->meta, ClockMeta(kSlotInvisible, 0), ClockMeta(kSlotConstruction, 0)))
+			FreeSlot(h);
+	}
+}
+
+//һkSlotConstruction״̬slot߶ռslot
+void ClockCache::FreeSlot(ClockHandle* h)
+{
+	(h->deleter)(h->key(), h->value);
+	port::AtomicFetchAdd(&usage_, -static_cast<intptr_t>(h->charge));
+	free(h->key_data);
+	h->key_data = NULL;
+
+	if(h->detached){
+		free(h);
+		return;
+	}
+
+	//ʱ̽ӵdisplacements
+	uint32_t index = static_cast<uint32_t>(h->hash) & mask_;
+	const uint32_t increment = ProbeIncrement(h->hash);
+	while(&slots_[index] != h){
+		port::AtomicFetchAdd(&slots_[index].displacements, -1);
+		index = (index + increment) & mask_;
+	}
+
+	port::AtomicFetchAdd(&occupancy_, -1);
+	//̵߳ʱãֻ޸״̬
+	port::AtomicFetchAdd(&h->meta, ClockMeta(kSlotEmpty, 0) - ClockMeta(kSlotConstruction, 0));
+}
+
+//Ĳңȼټ飬ƥʱ
+Cache::Handle* ClockCache::Lookup(const Slice& key, uint64_t hash)
+{
+	uint32_t index = static_cast<uint32_t>(hash) & mask_;
+	const uint32_t increment = ProbeIncrement(hash);
+	for(uint32_t probes = 0; probes <= mask_; probes ++){
+		ClockHandle* h = &slots_[index];
+		intptr_t old = port::AtomicFetchAdd(&h->meta, 1);
+		if(ClockState(old) == kSlotVisible && h->hash == hash && key == h->key()){
+			if(h->usage == 0) //ʱÿζдͬһcache line
+				h->usage = 1;
+			return reinterpret_cast<Cache::Handle*>(h);
+		}
+		Unref(h);
 
-	virtual Handle* Insert(const Slice& key, void* value, size_t charge, void (*deleter)(const Slice& key, void* value))
+		//ûentryslot̽⣬key
+		if(h->displacements == 0)
+			break;
+		index = (index + increment) & mask_;
+	}
+
+	return NULL;
+}
+
+void ClockCache::Release(Cache::Handle* handle)
+{
+	Unref(reinterpret_cast<ClockHandle*>(handle));
+}
+
+//̽һslotΪkSlotConstructionslotdisplacements
+ClockHandle* ClockCache::ClaimSlot(uint64_t hash)
+{
+	uint32_t index = static_cast<uint32_t>(hash) & mask_;
+	const uint32_t increment = ProbeIncrement(hash);
+	uint32_t probes = 0;
+	for(; probes <= mask_; probes ++){
+		ClockHandle* h = &slots_[index];
+		intptr_t m;
+		//slotϿLookupʱã
+		while(ClockState(m = h->meta) == kSlotEmpty){
+			if((m & kClockRefsMask) == 0 && port::AtomicCompareAndSwapWord(&h->meta, m, ClockMeta(kSlotConstruction, 0)))
+				return h;
+		}
+
+		port::AtomicFetchAdd(&h->displacements, 1);
+		index = (index + increment) & mask_;
+	}
+
+	//ûпslotdisplacements
+	index = static_cast<uint32_t>(hash) & mask_;
+	for(uint32_t i = 0; i < probes; i ++){
+		port::AtomicFetchAdd(&slots_[index].displacements, -1);
+		index = (index + increment) & mask_;
+	}
+	return NULL;
+}
+
+//clockɨ裺õentryλΪ10ڶλ
+bool ClockCache::EvictOne()
+{
+	for(uint32_t step = 0; step < 2 * (mask_ + 1); step ++){
+		ClockHandle* h = &slots_[clock_hand_];
+		clock_hand_ = (clock_hand_ + 1) & mask_;
+
+		intptr_t m = h->meta;
+		if(ClockState(m) != kSlotVisible || (m & kClockRefsMask) != 0)
+			continue;
+
+		if(h->usage != 0){
+			h->usage = 0;
+			continue;
+		}
+
+		if(port::AtomicCompareAndSwapWord(&h->meta, ClockMeta(kSlotVisible, 0), ClockMeta(kSlotConstruction, 0))){
+			FreeSlot(h);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//keyӦentryΪkSlotInvisibleһͷʱ
+void ClockCache::EraseLocked(const Slice& key, uint64_t hash)
+{
+	uint32_t index = static_cast<uint32_t>(hash) & mask_;
+	const uint32_t increment = ProbeIncrement(hash);
+	for(uint32_t probes = 0; probes <= mask_; probes ++){
+		ClockHandle* h = &slots_[index];
+		intptr_t old = port::AtomicFetchAdd(&h->meta, 1);
+		if(ClockState(old) == kSlotVisible && h->hash == hash && key == h->key()){
+			intptr_t m;
+			while(ClockState(m = h->meta) == kSlotVisible){
+				if(port::AtomicCompareAndSwapWord(&h->meta, m, m - ClockMeta(kSlotVisible, 0) + ClockMeta(kSlotInvisible, 0)))
+					break;
+			}
+			Unref(h);
+			return;
+		}
+		Unref(h);
+
+		if(h->displacements == 0)
+			break;
+		index = (index + increment) & mask_;
+	}
+}
+
+Cache::Handle* ClockCache::Insert(const Slice& key, uint64_t hash, void* value, size_t charge, void (*deleter)(const Slice& key, void* v), Cache::Priority priority)
+{
+	MutexLock l(&mutex_);
+	//ûϵentry
+	EraseLocked(key, hash);
+
+	//sloṱ
+	while((static_cast<size_t>(usage_) + charge > capacity_ || static_cast<size_t>(occupancy_) >= max_occupancy_) && EvictOne()){
+	}
+
+	ClockHandle* h = NULL;
+	if(static_cast<size_t>(occupancy_) < max_occupancy_)
+		h = ClaimSlot(hash);
+
+	if(h == NULL){ //entryãһtableеhandleReleaseʱͷ
+		h = reinterpret_cast<ClockHandle*>(malloc(sizeof(ClockHandle)));
+		memset(h, 0x00, sizeof(ClockHandle));
+		h->detached = true;
+		h->meta = ClockMeta(kSlotInvisible, 1);
+	}
+
+	h->value = value;
+	h->deleter = deleter;
+	h->charge = charge;
+	h->hash = hash;
+	h->key_length = key.size();
+	h->key_data = reinterpret_cast<char*>(malloc(key.size() > 0 ? key.size() : 1));
+	memcpy(h->key_data, key.data(), key.size());
+	//entryķλΪ0ûٴеentryһɨͻᱻ̭scanἷȵ㣻
+	//ȼentryһλ
+	h->usage = (priority == Cache::HIGH) ? 1 : 0;
+	port::AtomicFetchAdd(&usage_, static_cast<intptr_t>(charge));
+
+	if(!h->detached){
+		port::AtomicFetchAdd(&occupancy_, 1);
+		//ɼͬʱзظߵ
+		port::AtomicFetchAdd(&h->meta, ClockMeta(kSlotVisible, 1) - ClockMeta(kSlotConstruction, 0));
+	}
+
+	return reinterpret_cast<Cache::Handle*>(h);
+}
+
+void ClockCache::Erase(const Slice& key, uint64_t hash)
+{
+	MutexLock l(&mutex_);
+	EraseLocked(key, hash);
+}
+
+//hashĸλkey䵽2^num_shard_bitsshardϣÿshardж
+template<class CacheShard>
+class ShardedCache : public Cache
+{
+public:
+	explicit ShardedCache(int num_shard_bits) : num_shard_bits_(num_shard_bits), last_id_(0)
+	{
+		shards_ = new CacheShard[NumShards()];
+	}
+
+	virtual ~ShardedCache()
 	{
-		const uint32_t hash = HashSlice(key);
-		return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter);
+		delete []shards_;
+	}
+
+	int NumShards() const { return 1 << num_shard_bits_; };
+
+	CacheShard* GetShard(int i) { return &shards_[i]; };
+
+	virtual Handle* Insert(const Slice& key, void* value, size_t charge, void (*deleter)(const Slice& key, void* value), Priority priority)
+	{
+		const uint64_t hash = HashSlice(key);
+		return shards_[Shard(hash)].Insert(key, hash, value, charge, deleter, priority);
 	}
 
 	virtual Handle* Lookup(const Slice& key)
 	{
-		const uint32_t hash = HashSlice(key);
-		return shard_[Shard(hash)].Lookup(key, hash);
+		const uint64_t hash = HashSlice(key);
+		return shards_[Shard(hash)].Lookup(key, hash);
 	}
 
 	virtual void Release(Handle* handle)
 	{
-		LRUHandle* h = reinterpret_cast<LRUHandle*>(handle);
-		shard_[Shard(h->hash)].Release(handle);
+		shards_[Shard(CacheShard::HandleHash(handle))].Release(handle);
 	}
 
 	virtual void Erase(const Slice& key)
 	{
-		const uint32_t hash = HashSlice(key);
-		shard_[Shard(hash)].Erase(key);
+		const uint64_t hash = HashSlice(key);
+		shards_[Shard(hash)].Erase(key, hash);
 	}
 
 	virtual void* Value(Handle* handle) 
 	{
-		return reinterpret_cast<LRUHandle*>(handle)->value;
+		return CacheShard::HandleValue(handle);
 	}
 
 	virtual uint64_t NewId() 
@@ -326,32 +694,58 @@ public:
 	}
 
 private:
-	static inline uint32_t HashSlice(const Slice& s)
+	static inline uint64_t HashSlice(const Slice& s)
 	{
-		return Hash(s.data(), s.size(), 0);
+		return Hash64(s.data(), s.size(), 0);
 	}
 
-	static uint32_t Shard(uint32_t hash)
+	//ȡ64λhashĸnum_shard_bits_λshardڲɢбʹõλ߻
+	uint32_t Shard(uint64_t hash) const
 	{
-		return hash >> (32 - kNumShardBits); //hash % 16
+		return num_shard_bits_ > 0 ? static_cast<uint32_t>(hash >> (64 - num_shard_bits_)) : 0;
 	}
 
 private:
-	LRUCache shard_[kNumShards];
+	const int num_shard_bits_;
+	CacheShard* shards_;
 	port::Mutex id_mutex_;
 	uint64_t last_id_;
-
 };
+
+static const int kMaxShardBits = 10;
+
+static int SanitizeShardBits(int num_shard_bits)
+{
+	if(num_shard_bits < 0)
+		return 0;
+	if(num_shard_bits > kMaxShardBits)
+		return kMaxShardBits;
+	return num_shard_bits;
+}
+
 }
 
 //LRUCacheʵ
-Cache* NewLRUCache(size_t capacity) 
+Cache* NewLRUCache(size_t capacity, int num_shard_bits, double high_pri_pool_ratio) 
 {
-		return new ShardedLRUCache(capacity);
-}
+	ShardedCache<LRUCache>* cache = new ShardedCache<LRUCache>(SanitizeShardBits(num_shard_bits));
+	//ÿһshardcapacity
+	const size_t per_shard = (capacity + (cache->NumShards() - 1)) / cache->NumShards();
+	for(int s = 0; s < cache->NumShards(); s ++)
+		cache->GetShard(s)->SetCapacity(per_shard, high_pri_pool_ratio);
 
+	return cache;
 }
 
+Cache* NewClockCache(size_t capacity, int num_shard_bits, size_t estimated_entry_charge)
+{
+	ShardedCache<ClockCache>* cache = new ShardedCache<ClockCache>(SanitizeShardBits(num_shard_bits));
+	const size_t per_shard = (capacity + (cache->NumShards() - 1)) / cache->NumShards();
+	for(int s = 0; s < cache->NumShards(); s ++)
+		cache->GetShard(s)->SetCapacity(per_shard, estimated_entry_charge);
 
+	return cache;
+}
 
+}
 
@@ -6,7 +6,18 @@
 
 namespace leveldb{
 
-extern Cache* NewLRUCache(size_t capacity);
+class Cache;
+
+//num_shard_bitsshardĸ(2^num_shard_bits)ÿshardж
+//high_pri_pool_ratio > 0ʱΪֶLRU²ĵȼentryȽöΣٴвŽΣ
+//ռcapacityhigh_pri_pool_ratioĲֽöΡһԵscanֻöڻ̭
+//ȼ(index/filter block)entryֱӽ뱣Ρhigh_pri_pool_ratioΪ0ʱͬͨLRU
+extern Cache* NewLRUCache(size_t capacity, int num_shard_bits = 4, double high_pri_pool_ratio = 0.0);
+
+//CLOCKûcacheLookupкReleaseʺʺܸߡ̺߳ܶĳ
+//slot鰴capacity / estimated_entry_chargeԤȷ䣬entryʵchargeԶСڹֵʱ
+//slotcapacity꣬cacheɵentryslot
+extern Cache* NewClockCache(size_t capacity, int num_shard_bits = 6, size_t estimated_entry_charge = 4096);
 
 class Cache
 {
@@ -16,7 +27,14 @@ public:
 
 	struct Handle {};
 
-	virtual Handle* Insert(const Slice& key, void* value, size_t charge, void (*deleter)(const Slice& key, void* value)) = 0;
+	//entryȼHIGHindexfilterҪפblock
+	enum Priority
+	{
+		HIGH,
+		LOW
+	};
+
+	virtual Handle* Insert(const Slice& key, void* value, size_t charge, void (*deleter)(const Slice& key, void* value), Priority priority = LOW) = 0;
 	virtual Handle* Lookup(const Slice& key) = 0;
 
 	virtual void Release(Handle* handle) = 0;
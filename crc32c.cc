@@ -1,6 +1,13 @@
 #include "crc32c.h"
 #include <stdint.h>
+#include <string.h>
 #include "coding.h"
+#include "port.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <nmmintrin.h>
+#define LEVELDB_CRC32C_SSE42
+#endif
 
 namespace leveldb{
 namespace crc32c{
@@ -274,11 +281,10 @@ static inline uint32_t LE_LOAD32(const uint8_t* p)
 	return DecodeFixed32(reinterpret_cast<const char*>(p));
 }
 
-uint32_t Extend(uint32_t init_crc, const char* data, size_t n)
+//ʵ֣CPU֧SSE4.2ʱʹálΪβȡcrc״̬
+static uint32_t ExtendPortable(uint32_t l, const uint8_t* p, size_t n)
 {
-	const uint8_t* p = (uint8_t *)data;
-	cosnt uint8_t *e = p + n;
-	uint32_t l = crc ^ 0xffffffffu;
+	const uint8_t* e = p + n;
 
 #define STEP1 do {                              \
 	int c = (l & 0xff) ^ *p++;                  \
@@ -317,12 +323,128 @@ uint32_t Extend(uint32_t init_crc, const char* data, size_t n)
 		STEP1;
 	}
 
-	return l ^ 0xffffffffu;
+#undef STEP4
+#undef STEP1
+
+	return l;
 }
 
+#ifdef LEVELDB_CRC32C_SSE42
+//·һݷֳɵȳ3飬3crc32ָˮ߻ͬʱִС
+//crcԵģprocess(s, A||B) = Shift_B(process(s, A)) ^ process(0, B)
+//Shift_B(s)s|B|0ֽڵcrcs4ֽڲ4űõ
+static const size_t kLongBlock = 4096;
+static const size_t kShortBlock = 256;
+
+static uint32_t long_shift_[4][256];
+static uint32_t short_shift_[4][256];
+
+static void InitShiftTable(uint32_t table[4][256], size_t zeros)
+{
+	static const uint8_t kZeros[kLongBlock] = {0};
 
+	//ShiftsԵģÿbitĽֽٰ
+	uint32_t bit_shift[32];
+	for(int k = 0; k < 32; k ++)
+		bit_shift[k] = ExtendPortable(1u << k, kZeros, zeros);
+
+	for(int i = 0; i < 4; i ++){
+		for(uint32_t v = 0; v < 256; v ++){
+			uint32_t r = 0;
+			for(int j = 0; j < 8; j ++){
+				if(v & (1u << j))
+					r ^= bit_shift[8 * i + j];
+			}
+			table[i][v] = r;
+		}
+	}
 }
+
+static inline uint32_t Shift(const uint32_t table[4][256], uint32_t crc)
+{
+	return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^ table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
 }
 
+static inline uint64_t LE_LOAD64(const uint8_t* p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+//blockΪkLongBlockkShortBlock(8ı)3 * blockֽ
+__attribute__((target("sse4.2")))
+static inline uint32_t ThreeWay(uint32_t l, const uint8_t* p, size_t block, const uint32_t table[4][256])
+{
+	uint64_t c0 = l, c1 = 0, c2 = 0;
+	const uint8_t* p1 = p + block;
+	const uint8_t* p2 = p1 + block;
+	for(size_t i = 0; i < block; i += 8){
+		c0 = _mm_crc32_u64(c0, LE_LOAD64(p + i));
+		c1 = _mm_crc32_u64(c1, LE_LOAD64(p1 + i));
+		c2 = _mm_crc32_u64(c2, LE_LOAD64(p2 + i));
+	}
 
+	uint32_t crc = Shift(table, static_cast<uint32_t>(c0)) ^ static_cast<uint32_t>(c1);
+	return Shift(table, crc) ^ static_cast<uint32_t>(c2);
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t ExtendSSE42(uint32_t l, const uint8_t* p, size_t n)
+{
+	const uint8_t* e = p + n;
 
+	//ȶ뵽8ֽ
+	while(p != e && (reinterpret_cast<uintptr_t>(p) & 7) != 0)
+		l = _mm_crc32_u8(l, *p++);
+
+	while(static_cast<size_t>(e - p) >= 3 * kLongBlock){
+		l = ThreeWay(l, p, kLongBlock, long_shift_);
+		p += 3 * kLongBlock;
+	}
+
+	while(static_cast<size_t>(e - p) >= 3 * kShortBlock){
+		l = ThreeWay(l, p, kShortBlock, short_shift_);
+		p += 3 * kShortBlock;
+	}
+
+	uint64_t l64 = l;
+	while(e - p >= 8){
+		l64 = _mm_crc32_u64(l64, LE_LOAD64(p));
+		p += 8;
+	}
+	l = static_cast<uint32_t>(l64);
+
+	while(p != e)
+		l = _mm_crc32_u8(l, *p++);
+
+	return l;
+}
+#endif
+
+typedef uint32_t (*ExtendFunc)(uint32_t l, const uint8_t* p, size_t n);
+
+static port::OnceType extend_once = LEVELDB_ONCE_INIT;
+static ExtendFunc extend_impl = ExtendPortable;
+
+//CPUIDѡʵֻ֣ڵһεʱִ
+static void InitExtend()
+{
+#ifdef LEVELDB_CRC32C_SSE42
+	if(port::HasSSE42()){
+		InitShiftTable(long_shift_, kLongBlock);
+		InitShiftTable(short_shift_, kShortBlock);
+		extend_impl = ExtendSSE42;
+	}
+#endif
+}
+
+uint32_t Extend(uint32_t init_crc, const char* data, size_t n)
+{
+	port::InitOnce(&extend_once, InitExtend);
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+	return extend_impl(init_crc ^ 0xffffffffu, p, n) ^ 0xffffffffu;
+}
+
+}
+}
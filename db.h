@@ -47,6 +47,9 @@ public:
 	virtual Status Delete(const WriteOptions& opt, const Slice& key) = 0;
 	virtual Status Write(const WriteOptions& opt, WriteBatch* updates) = 0;
 	virtual Status Get(const ReadOptions& opt, const Slice& key, std::string* value) = 0;
+	//ѯnkeyvalues[i]statuses[i]Ϊkeys[i]ĽGetͬ
+	//ĬʵGet
+	virtual void MultiGet(const ReadOptions& opt, const Slice* keys, int n, std::string* values, Status* statuses);
 	virtual Iterator* NewIterator(const ReadOptions& opt) = 0; 
 
 	virtual const Snapshot* GetSnapshot() = 0;
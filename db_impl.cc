@@ -13,6 +13,7 @@
 #include "log_reader.h"
 #include "log_write.h"
 #include "memtable.h"
+#include "memtablerep.h"
 #include "table_cache.h"
 #include "version_edit.h"
 #include "version_set.h"
@@ -38,10 +39,28 @@ struct DBImpl::Writer
 	Status status;
 	WriteBatch* batch;
 	bool sync;
-	bool done;
+	//kQueuedwriters_ŶӣkGroupedѾleaderȡwriters_ȴдɣkDoneд
+	enum State
+	{
+		kQueued,
+		kGrouped,
+		kDone
+	};
+	State state;
 	port::CondVar cv;
 
-	explicit Writer(port::Mutex* mu) : cv(mu){};
+	//ֶֻдleaderЧleaderдWALmemtableд
+	std::vector<Writer*> followers;
+	WriteBatch* updates;
+	SequenceNumber last_sequence;
+	int pending_inserts; //ûɲfollower
+
+	//leaderдӦmemtablefollower˵NULLʾleaderҪ䲢
+	MemTable* mem;
+	Writer* leader;
+
+	explicit Writer(port::Mutex* mu) : cv(mu), updates(NULL), last_sequence(0), pending_inserts(0), 
+		mem(NULL), leader(NULL){};
 };
 
 struct DBImpl::CompactionState
@@ -94,6 +113,13 @@ Options SanitizeOptions(const std::string& dbname, const InternalKeyComparator*
 	ClipToRange(&result.max_open_files, 64 + kNumNonTableCacheFiles, 50000); //74 ~ 50000
 	ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30); //64K ~ 256M
 	ClipToRange(&result.block_size, 1 << 10, 4 << 20); //1K ~ 4M
+	ClipToRange(&result.max_background_compactions, 1, 64);
+	ClipToRange(&result.max_background_flushes, 1, 64);
+	ClipToRange(&result.max_subcompactions, 1, 64);
+	ClipToRange(&result.parallel_compression_threads, 1, 64);
+	//memtable repֲ֧ʱ˻ذд˳
+	if(result.memtable_factory != NULL && !result.memtable_factory->IsInsertConcurrentlySupported())
+		result.allow_concurrent_memtable_write = false;
 
 	if(result.info_log == NULL){
 		src.env->CreateDir(dbname);
@@ -105,7 +131,7 @@ Options SanitizeOptions(const std::string& dbname, const InternalKeyComparator*
 	}
 
 	if(result.block_cache == NULL)
-		result.block_cache = NewLRUCache(8 << 20); //LRU CACHEΪ8M?ǲ̫Сˣ
+		result.block_cache = NewLRUCache(8 << 20, 4, 0.5); //LRU CACHEΪ8M?ǲ̫СˣһΪΣֹscanȵblock
 
 	return result;
 }
@@ -116,11 +142,14 @@ DBImpl::DBImpl(const Options& raw_opt, const std::string& dbname) : env_(raw_opt
 	owns_info_log_(options_.info_log != raw_opt.info_log),
 	owns_cache_(options_.block_cache != raw_opt.block_cache),
 	dbname_(dbname), db_lock_(NULL), shutting_down_(NULL),
-	bg_cv_(&mutex_), mem_(new MemTable(internal_comparator_)), imm_(NULL),
+	bg_cv_(&mutex_), mem_(new MemTable(internal_comparator_, options_.memtable_factory, options_.allow_concurrent_memtable_write)), imm_(NULL),
 	logfile_(NULL), logfile_number_(0), log_(NULL), seed_(0),
-	tmp_batch_(new WriteBatch)
+	allocated_sequence_(0)
 {
-	bg_compaction_scheduled_ = false;
+	bg_flush_scheduled_ = 0;
+	bg_compaction_scheduled_ = 0;
+	bg_compaction_running_ = 0;
+	manifest_writing_ = false;
 	manual_compaction_ = NULL;
 	//memtable ü
 	mem_->Ref();
@@ -131,13 +160,17 @@ DBImpl::DBImpl(const Options& raw_opt, const std::string& dbname) : env_(raw_opt
 	table_cache_ = new TableCache(dbname_, &options_, table_cache_size);
 
 	versions_ = new VersionSet(dbname_, &options_, table_cache_, &internal_comparator_);
+
+	//Envĺ̨̳߳أLOW̳߳ضcompaction߳
+	env_->SetBackgroundThreads(options_.max_background_compactions + options_.max_subcompactions - 1, Env::LOW);
+	env_->SetBackgroundThreads(options_.max_background_flushes, Env::HIGH);
 }
 
 DBImpl::~DBImpl()
 {
 	mutex_.Lock();
 	shutting_down_.Release_Store(this);
-	while(bg_compaction_scheduled_){
+	while(bg_compaction_scheduled_ > 0 || bg_flush_scheduled_ > 0){
 		bg_cv_.Wait();
 	}
 	mutex_.Unlock();
@@ -152,7 +185,6 @@ DBImpl::~DBImpl()
 	if(imm_ != NULL)
 		imm_->Unref();
 
-	delete tmp_batch_;
 	delete log_;
 	delete logfile_;
 	delete table_cache_;
@@ -395,7 +427,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, VersionEdit* edit, SequenceNu
 		WriteBatchInternal::SetContents(&batch, record);
 
 		if(mem == NULL){
-			mem = new MemTable(internal_comparator_);
+			mem = new MemTable(internal_comparator_, options_.memtable_factory);
 			mem->Ref();
 		}
 		//¼дmemtable
@@ -410,6 +442,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, VersionEdit* edit, SequenceNu
 			 *max_sequence = last_seq;
 
 		if(mem->ApproximateMemoryUsage() > options_.write_buffer_size){ //ڴʹôﵽ
+			mem->MarkImmutable();
 			status = WriteLevel0Table(mem, edit, NULL); 
 			if(!status.ok())
 				break;
@@ -421,8 +454,10 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, VersionEdit* edit, SequenceNu
 	}
 	
 	//дlevel 0
-	if(status.ok() && mem != NULL)
+	if(status.ok() && mem != NULL){
+		mem->MarkImmutable();
 		status = WriteLevel0Table(mem, edit, NULL);
+	}
 
 	if(mem != NULL)
 		mem->Unref();
@@ -485,11 +520,9 @@ void DBImpl::CompactMemTable()
 	assert(imm_ != NULL);
 
 	VersionEdit edit;
-	Version* base = versions_->current();
-	base->Ref();
-	//imm_д뵽block table
-	Status s = WriteLevel0Table(imm_, &edit, base);
-	base->Unref();
+	//imm_д뵽block tableУflushcompactionڲͬ߳вִУ
+	//ֱӷlevel 0еcompactionΧص
+	Status s = WriteLevel0Table(imm_, &edit, NULL);
 
 	if(s.ok() && shutting_down_.Acquire_Load())
 		s = Status::IOError("Deleting DB during memtable compaction");
@@ -497,7 +530,7 @@ void DBImpl::CompactMemTable()
 	if(s.ok()){
 		edit.SetPrevLogNumber(0);
 		edit.SetLogNumber(logfile_number_);
-		s = versions_->LogAndApply(&edit, &mutex_);
+		s = LogAndApply(&edit);
 	}
 
 	//ļ
@@ -553,6 +586,7 @@ void DBImpl::TEST_CompactRange(int level, const Slice* begin, const Slice* end)
 	ManualCompaction manual;
 	manual.level = level;
 	manual.done = false;
+	manual.in_progress = false;
 	if(begin == NULL)
 		manual.begin = NULL;
 	else{
@@ -591,63 +625,114 @@ void DBImpl::RecordBackgroundError(const Status& s)
 	}
 }
 
+//̨߳̿ͬʱװµversionMANIFESTдҪл
+Status DBImpl::LogAndApply(VersionEdit* edit)
+{
+	mutex_.AssertHeld();
+
+	while(manifest_writing_)
+		bg_cv_.Wait();
+
+	manifest_writing_ = true;
+	Status s = versions_->LogAndApply(edit, &mutex_);
+	manifest_writing_ = false;
+	bg_cv_.SignalAll();
+
+	return s;
+}
+
 void DBImpl::MaybeScheduleCompaction()
 {
 	mutex_.AssertHeld();
 
-	//ѾʼCompact scheduled
-	if(bg_compaction_scheduled_){
-	}
-	else if(shutting_down_.Acquire_Load()){ //DBڱɾ
+	if(shutting_down_.Acquire_Load()){ //DBڱɾ
 	}
 	else if(!bg_error_.ok()){ //Ѿһ󣬲ܽCompact
 	}
-	else if(imm_ == NULL && manual_compaction_ == NULL && !versions_->NeedsCompaction()){ //ûҪcompact
-	}
 	else{
-		bg_compaction_scheduled_ = true;
-		env_->Schedule(&DBImpl::BGWork, this); //һ߳̽жӦcompact൱ݿĺ̨߳
+		//imm_ֻһͬһʱֻҪһflush
+		if(imm_ != NULL && bg_flush_scheduled_ == 0){
+			bg_flush_scheduled_ ++;
+			env_->Schedule(&DBImpl::BGWorkFlush, this, Env::HIGH);
+		}
+
+		//compactionLOWִ̳߳Уmax_background_compactions
+		while(bg_compaction_scheduled_ < options_.max_background_compactions
+			&& (manual_compaction_ != NULL || versions_->NeedsCompaction())){
+			bg_compaction_scheduled_ ++;
+			env_->Schedule(&DBImpl::BGWorkCompaction, this, Env::LOW);
+		}
 	}
 }
 
-void DBImpl::BGWork(void* db)
+void DBImpl::BGWorkFlush(void* db)
 {
-	reinterpret_cast<DBImpl*>(db)->BackgroundCall();
+	reinterpret_cast<DBImpl*>(db)->BackgroundFlushCall();
 }
 
-void DBImpl::BackgroundCall()
+void DBImpl::BGWorkCompaction(void* db)
+{
+	reinterpret_cast<DBImpl*>(db)->BackgroundCompactionCall();
+}
+
+void DBImpl::BackgroundFlushCall()
 {
 	MutexLock l(&mutex_);
-	assert(bg_compaction_scheduled_);
+	assert(bg_flush_scheduled_ > 0);
 
 	if(shutting_down_.Acquire_Load()){
 	}
 	else if(!bg_error_.ok()){
 	}
-	else
-		BackgroundCompaction(); //̨Compact
+	else if(imm_ != NULL)
+		CompactMemTable(); //imm_дlevel 0
 
-	bg_compaction_scheduled_ = false;
+	bg_flush_scheduled_ --;
 
-	//ٴμcompact Schedule
+	//µlevel 0ļܴcompaction
 	MaybeScheduleCompaction();
+	bg_cv_.SignalAll();
 }
 
-void DBImpl::BackgroundCompaction()
+void DBImpl::BackgroundCompactionCall()
 {
-	mutex_.AssertHeld();
+	MutexLock l(&mutex_);
+	assert(bg_compaction_scheduled_ > 0);
 
-	//ȶimm_ tableдļ
-	if(imm_ != NULL){
-		CompactMemTable();
-		return ;
+	bool made_progress = false;
+	if(shutting_down_.Acquire_Load()){
+	}
+	else if(!bg_error_.ok()){
 	}
+	else
+		made_progress = BackgroundCompaction(); //̨Compact
 
-	Compaction* c;
-	bool is_manual = (manual_compaction_ != NULL);
+	bg_compaction_scheduled_ --;
+
+	//ûѡִеcompaction(ļcompactionռ)ʱµȣ
+	//compactionʱٵȣת
+	if(made_progress)
+		MaybeScheduleCompaction();
+
+	bg_cv_.SignalAll();
+}
+
+//Ƿѡִһcompaction
+bool DBImpl::BackgroundCompaction()
+{
+	mutex_.AssertHeld();
+
+	Compaction* c = NULL;
+	bool is_manual = false;
 	InternalKey manual_end;
-	if(is_manual){
+	if(manual_compaction_ != NULL){
 		ManualCompaction* m = manual_compaction_;
+		//ֶcompactionռִУеcompaction
+		if(m->in_progress || bg_compaction_running_ > 0)
+			return false;
+
+		is_manual = true;
+		m->in_progress = true;
 		//ͨversion setCompactмõһCompaction
 		c = versions_->CompactRange(m->level, m->begin, m->end);
 
@@ -665,6 +750,11 @@ void DBImpl::BackgroundCompaction()
 	else //ֶƶCompactΧĻversionsCompactõһCompaction
 		c = versions_->PickCompaction();
 
+	if(c == NULL && !is_manual)
+		return false;
+
+	bg_compaction_running_ ++;
+
 	Status status;
 	if(c == NULL){
 	}
@@ -675,7 +765,7 @@ void DBImpl::BackgroundCompaction()
 		c->edit()->DeleteFile(c->level(), f->number);
 		c->edit()->AddFile(c->level() + 1, f->number, f->file_size, f->smallest, f->largest);
 
-		status = versions_->LogAndApply(c->edit(), &mutex_);
+		status = LogAndApply(c->edit());
 		if(!status.ok()) //һ
 			RecordBackgroundError(status);
 
@@ -683,6 +773,8 @@ void DBImpl::BackgroundCompaction()
 		Log(options_.info_log, "Moved #%lld to level-%d %lld bytes %s: %s\n",
 			static_cast<unsigned long long>(f->number), c->level() + 1, static_cast<unsigned long long>(f->file_size),
 			status.ToString().c_str(), versions_->LevelSummary(&tmp));
+
+		c->MarkFilesBeingCompacted(false);
 	}
 	else{ //صݺϲ
 		CompactionState* compact = new CompactionState(c);
@@ -691,12 +783,15 @@ void DBImpl::BackgroundCompaction()
 			RecordBackgroundError(status);
 
 		CleanupCompaction(compact);
+		//ReleaseInputs֮ǰǣ֮input filesѾͷ
+		c->MarkFilesBeingCompacted(false);
 		c->ReleaseInputs();
 		//ɾļ
 		DeleteObsoleteFiles();
 	}
 
 	delete c;
+	bg_compaction_running_ --;
 
 	if(status.ok()){
 	}
@@ -714,8 +809,11 @@ void DBImpl::BackgroundCompaction()
 			 m->tmp_storage = manual_end;
 			 m->begin = &m->tmp_storage;
 		}
+		m->in_progress = false;
 		manual_compaction_ = NULL;
 	}
+
+	return true;
 }
 
 void DBImpl::CleanupCompaction(CompactionState* compact)
@@ -761,9 +859,18 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact)
 	};
 	//һtable filetable builder
 	std::string fname = TableFileName(dbname_, file_number);
-	Status s = env_->NewWritableFile(fname, &compact->outfile);
-	if(s.ok())
-		compact->builder = new TableBuilder(options_, compact->outfile);
+	Status s;
+	if(options_.use_direct_io_for_compaction)
+		s = env_->NewDirectWritableFile(fname, &compact->outfile);
+	else
+		s = env_->NewWritableFile(fname, &compact->outfile);
+	if(s.ok()){
+		//ļMaxOutputFileSizeԺŻлһkeyܳһ
+		const uint64_t max_size = compact->compaction->MaxOutputFileSize();
+		compact->outfile->SetPreallocationBlockSize(static_cast<size_t>(max_size + max_size / 10));
+		compact->outfile->SetBytesPerSync(options_.bytes_per_sync);
+		compact->builder = new TableBuilder(options_, compact->outfile, compact->compaction->level() + 1);
+	}
 
 	return s;
 }
@@ -840,13 +947,12 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact)
 		compact->compaction->edit()->AddFile(level + 1, out.number, out.file_size, out.smallest, out.largest);
 	}
 	//session setĸ
-	return versions_->LogAndApply(compact->compaction->edit(), &mutex_);
+	return LogAndApply(compact->compaction->edit());
 }
 
 Status DBImpl::DoCompactionWork(CompactionState* compact)
 {
 	const uint64_t start_micros = env_->NowMicros();
-	int64_t imm_micros = 0;
 
 	Log(options_.info_log,  "Compacting %d@%d + %d@%d files",
 		compact->compaction->num_input_files(0),
@@ -863,11 +969,175 @@ Status DBImpl::DoCompactionWork(CompactionState* compact)
 	else
 		compact->smallest_snapshot = snapshots_.oldest()->number_;
 
+	//ļ߽зֳɶcompaction
+	std::vector<Compaction*> shards;
+	versions_->SplitCompaction(compact->compaction, options_.max_subcompactions, &shards);
+
 	mutex_.Unlock();
 
+	Status status;
+	if(shards.empty())
+		status = DoCompactionShard(compact);
+	else
+		status = DoSubcompactions(compact, shards);
+
+	//ļCompactĺʱ
+	CompactionStats stats;
+	stats.micros = env_->NowMicros() - start_micros;
+	//input bytes output bytes
+	for(int which = 0; which < 2; which ++)
+		for(int i = 0; i < compact->compaction->num_input_files(which); i ++)
+			stats.bytes_read += compact->compaction->input(which, i)->file_size;
+
+	for(size_t i = 0; i < compact->outputs.size(); i ++)
+		stats.bytes_written += compact->outputs[i].file_size;
+
+	mutex_.Lock();
+	//~CompactionUnref input_version_Versionüֻmutex_޸
+	for(size_t i = 0; i < shards.size(); i++)
+		delete shards[i];
+
+	stats_[compact->compaction->level() + 1].Add(stats);
+
+	//Compact meta filescompactionһ԰װ
+	if(status.ok())
+		status = InstallCompactionResults(compact);
+
+	if(!status.ok())
+		RecordBackgroundError(status);
+
+	VersionSet::LevelSummaryStorage tmp;
+	Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
+
+	return status;
+}
+
+//һзֳcompactionһSubcompactionTask
+//compaction̺߳LOW̳߳еĸ̴߳nextʼ
+struct DBImpl::SubcompactionTask
+{
+	DBImpl* db;
+	std::vector<CompactionState*> states;
+	std::vector<Status> statuses;
+
+	port::Mutex mu;
+	port::CondVar cv;
+	size_t next; //һûб
+	size_t finished; //Ѿ
+	int refs; //DoSubcompactionsÿѾȵĸ̸߳һãһͷŵĸɾ
+
+	SubcompactionTask() : cv(&mu), next(0), finished(0), refs(1){};
+};
+
+//첢䣬ֱ䶼
+void DBImpl::RunSubcompactions(SubcompactionTask* task)
+{
+	MutexLock l(&task->mu);
+	while(task->next < task->states.size()){
+		const size_t i = task->next ++;
+
+		task->mu.Unlock();
+		Status s = DoCompactionShard(task->states[i]);
+		task->mu.Lock();
+
+		task->statuses[i] = s;
+		task->finished ++;
+		task->cv.SignalAll();
+	}
+}
+
+//߳̿䶼ԺűȣʱֻͷãٷDB
+void DBImpl::BGWorkSubcompaction(void* arg)
+{
+	SubcompactionTask* task = reinterpret_cast<SubcompactionTask*>(arg);
+	task->db->RunSubcompactions(task);
+	ReleaseSubcompactionTask(task);
+}
+
+void DBImpl::ReleaseSubcompactionTask(SubcompactionTask* task)
+{
+	bool last;
+	{
+		MutexLock l(&task->mu);
+		last = (-- task->refs == 0);
+	}
+
+	if(last)
+		delete task;
+}
+
+//compactionLOW̳߳أǰ߳Ҳ䣬ֻȴڱ䣬
+//̳߳رcompactionռʱɵǰ̴߳ȫ䣬
+//ȫɺѸԵļ˳ϲcompact
+Status DBImpl::DoSubcompactions(CompactionState* compact, const std::vector<Compaction*>& shards)
+{
+	Log(options_.info_log, "Compaction split into %d subcompactions", static_cast<int>(shards.size()));
+
+	SubcompactionTask* task = new SubcompactionTask;
+	task->db = this;
+	task->statuses.resize(shards.size());
+	for(size_t i = 0; i < shards.size(); i++){
+		CompactionState* sub = new CompactionState(shards[i]);
+		sub->smallest_snapshot = compact->smallest_snapshot;
+		task->states.push_back(sub);
+	}
+
+	//ǰ̴߳һ䣬ٵshards.size() - 1߳
+	const int helpers = static_cast<int>(shards.size()) - 1;
+	task->refs += helpers;
+	for(int i = 0; i < helpers; i++)
+		env_->Schedule(&DBImpl::BGWorkSubcompaction, task, Env::LOW);
+
+	RunSubcompactions(task);
+
+	std::vector<CompactionState*> states;
+	std::vector<Status> statuses;
+	{
+		MutexLock l(&task->mu);
+		while(task->finished < task->states.size())
+			task->cv.Wait();
+
+		states.swap(task->states);
+		statuses.swap(task->statuses);
+	}
+	ReleaseSubcompactionTask(task);
+
+	Status status;
+	for(size_t i = 0; i < states.size(); i++){
+		CompactionState* sub = states[i];
+		if(status.ok() && !statuses[i].ok())
+			status = statuses[i];
+
+		//ʧܵcompactionܻδɵļ
+		if(sub->builder != NULL){
+			sub->builder->Abandon();
+			delete sub->builder;
+		}
+		delete sub->outfile;
+
+		//ļcompactInstallCompactionResultsCleanupCompactionͳһ
+		compact->outputs.insert(compact->outputs.end(), sub->outputs.begin(), sub->outputs.end());
+		compact->total_bytes += sub->total_bytes;
+
+		delete sub;
+	}
+
+	return status;
+}
+
+//һcompaction(һcompaction)mutex_
+Status DBImpl::DoCompactionShard(CompactionState* compact)
+{
 	//һmerge iter
 	Iterator* input = versions_->MakeInputIterator(compact->compaction);
-	input->SeekToFirst();
+	const std::string* shard_start = compact->compaction->shard_start();
+	const std::string* shard_end = compact->compaction->shard_end();
+	if(shard_start != NULL){ //compaction㿪ʼ
+		InternalKey seek_key(*shard_start, kMaxSequenceNumber, kValueTypeForSeek);
+		input->Seek(seek_key.Encode());
+	}
+	else
+		input->SeekToFirst();
 
 	Status status;
 	ParsedInternalKey ikey;
@@ -875,21 +1145,13 @@ Status DBImpl::DoCompactionWork(CompactionState* compact)
 	bool has_current_user_key = false;
 
 	SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
+	//imm_дHIGH̳߳еflush𣬲compactionвִ
 	for(; input->Valid() && !shutting_down_.Acquire_Load(); ){
-		if(has_imm_.NoBarrier_Load() != NULL){
-			const uint64_t imm_start = env_->NowMicros();
-			mutex_.Lock();
-			if(imm_ != NULL){ //Compact mem tableΪimmпзǳΧKEY VALUEɾkey
-				CompactMemTable();
-				bg_cv_.SignalAll();
-			}
-
-			mutex_.Unlock();
-			imm_micros += (env_->NowMicros() - imm_start);
-		}
-
 		//жǷCompact
 		Slice key = input->key();
+		if(shard_end != NULL && user_comparator()->Compare(ExtractUserKey(key), Slice(*shard_end)) >= 0)
+			break;
+
 		if(compact->compaction->ShouldStopBefore(key) && compact->builder != NULL){
 			status = FinishCompactionOutputFile(compact, input);
 			if(!status.ok())
@@ -958,30 +1220,6 @@ Status DBImpl::DoCompactionWork(CompactionState* compact)
 	delete input;
 	input = NULL;
 
-	//ļCompactĺʱȥimm Compactĺʱ
-	CompactionStats stats;
-	stats.micros = env_->NowMicros() - start_micros - imm_micros;
-	//input bytes output bytes
-	for(int which = 0; which < 2; which ++)
-		for(int i = 0; i < compact->compaction->num_input_files(which); i ++)
-			stats.bytes_read += compact->compaction->input(which, i)->file_size;
-
-	for(size_t i = 0; i < compact->outputs.size(); i ++)
-		stats.bytes_written += compact->outputs[i].file_size;
-
-	mutex_.Lock();
-	stats_[compact->compaction->level() + 1].Add(stats);
-
-	//Compact meta files
-	if(status.ok())
-		status = InstallCompactionResults(compact);
-
-	if(!status.ok())
-		RecordBackgroundError(status);
-
-	VersionSet::LevelSummaryStorage tmp;
-	Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
-
 	return status;
 }
 
@@ -1113,6 +1351,94 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key, std::string* va
 	return s;
 }
 
+namespace{
+//user keykeys±
+struct MultiGetKeyLess
+{
+	const Comparator* ucmp;
+	const Slice* keys;
+
+	MultiGetKeyLess(const Comparator* c, const Slice* k) : ucmp(c), keys(k){};
+	bool operator()(int a, int b) const
+	{
+		return ucmp->Compare(keys[a], keys[b]) < 0;
+	}
+};
+};
+
+//һμmem_imm_currentkey˳memtable
+//ʣµĽVersion::MultiGetļ
+void DBImpl::MultiGet(const ReadOptions& options, const Slice* keys, int n, std::string* values, Status* statuses)
+{
+	if(n <= 0)
+		return;
+
+	MutexLock l(&mutex_);
+	SequenceNumber snapshot;
+	if (options.snapshot != NULL)
+		snapshot = reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_;
+	else
+		snapshot = versions_->LastSequence();
+
+	MemTable* mem = mem_;
+	MemTable* imm = imm_;
+	Version* current = versions_->current();
+
+	mem->Ref();
+	if(imm != NULL) 
+		imm->Ref();
+	current->Ref();
+
+	bool have_stat_update = false;
+	Version::GetStats stats;
+
+	{
+		mutex_.Unlock();
+
+		std::vector<int> order(n);
+		for(int i = 0; i < n; i ++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), MultiGetKeyLess(user_comparator(), keys));
+
+		std::vector<LookupKey*> lkeys(n);
+		std::vector<const LookupKey*> pending_keys;
+		std::vector<std::string*> pending_values;
+		std::vector<Status*> pending_statuses;
+		for(int j = 0; j < n; j ++){
+			const int i = order[j];
+			lkeys[j] = new LookupKey(keys[i], snapshot);
+
+			Status s;
+			if(mem->Get(*lkeys[j], &values[i], &s) || (imm != NULL && imm->Get(*lkeys[j], &values[i], &s))){
+				statuses[i] = s;
+			}
+			else{
+				pending_keys.push_back(lkeys[j]);
+				pending_values.push_back(&values[i]);
+				pending_statuses.push_back(&statuses[i]);
+			}
+		}
+
+		if(!pending_keys.empty()){
+			current->MultiGet(options, &pending_keys[0], static_cast<int>(pending_keys.size()), &pending_values[0], &pending_statuses[0], &stats);
+			have_stat_update = true;
+		}
+
+		for(int j = 0; j < n; j ++)
+			delete lkeys[j];
+
+		mutex_.Lock();
+	}
+
+	if(have_stat_update && current->UpdateStats(stats))
+		MaybeScheduleCompaction();
+
+	mem->Unref();
+	if (imm != NULL) 
+		imm->Unref();
+	current->Unref();
+}
+
 Iterator* DBImpl::NewIterator(const ReadOptions& opt)
 {
 	SequenceNumber latest_snapshot;
@@ -1155,36 +1481,46 @@ Status DBImpl::Delete(const WriteOptions& opt, const Slice& key)
 	return DB::Delete(opt, key);
 }
 
+//ˮд
+//1.writers_׵leaderϲһbatchsequenceдWAL
+//2.WALд뿪writers_һԿʼдWALmemtable_writers_
+//3.memtable_writers_едmemtable(InsertIntoMemTable)WAL˳򷢲LastSequence
+//  Զûȫд
 Status DBImpl::Write(const WriteOptions& opt, WriteBatch* my_batch)
 {
 	//һwriter
 	Writer w(&mutex_);
 	w.batch = my_batch;
 	w.sync = opt.sync;
-	w.done = false;
+	w.state = Writer::kQueued;
 
 	MutexLock l(&mutex_);
 	writers_.push_back(&w);
-	//ȴǰдɣ
-	while(!w.done && &w != writers_.front())
+	//ȴǰдɣȡwriters_Ժٿףwriters_ѾΪ
+	while(w.state == Writer::kGrouped || (w.state == Writer::kQueued && &w != writers_.front())){
+		if(w.mem != NULL){ //leaderҪԼbatchmemtable
+			FollowerInsert(&w);
+			continue;
+		}
 		w.cv.Wait();
+	}
 
-	if(w.done)
+	if(w.state == Writer::kDone)
 		return w.status;
 
 	Status status = MakeRoomForWrite(my_batch == NULL);
-	uint64_t last_sequence = versions_->LastSequence();
 	Writer* last_writer = &w;
 
 	if(status.ok() && my_batch != NULL){
-		WriteBatch* updates = BuildBatchGroup(&last_writer); //һµĶ
-		WriteBatchInternal::SetSequence(updates, last_sequence + 1);
-		last_sequence += WriteBatchInternal::Count(updates);
+		w.updates = BuildBatchGroup(&last_writer); //һµĶ
+		WriteBatchInternal::SetSequence(w.updates, allocated_sequence_ + 1);
+		allocated_sequence_ += WriteBatchInternal::Count(w.updates);
+		w.last_sequence = allocated_sequence_;
 
 		{
 			mutex_.Unlock();
 			//¼д־
-			status = log_->AddRecord(WriteBatchInternal::Contents(updates));
+			status = log_->AddRecord(WriteBatchInternal::Contents(w.updates));
 
 			bool sync_error = false;
 			if(status.ok() && opt.sync){
@@ -1192,29 +1528,20 @@ Status DBImpl::Write(const WriteOptions& opt, WriteBatch* my_batch)
 				if(!status.ok())
 					sync_error = true;
 			}
-			//дmem table
-			if(status.ok())
-				status = WriteBatchInternal::InsertInto(updates, mem_);
 
 			mutex_.Lock();
 			if(sync_error)
 				RecordBackgroundError(status);
 		}
-
-		if(updates == tmp_batch_)
-			tmp_batch_->Clear();
-
-		versions_->SetLastSequence(last_sequence);
 	}
 
-	//֪ͨǰд
+	//WAL׶ν뿪writers_һleaderʼд־
 	while(true){
 		Writer* ready = writers_.front();
 		writers_.pop_front();
 		if(ready != &w){
-			ready->status = status;
-			ready->done = true;
-			ready->cv.Signal();
+			ready->state = Writer::kGrouped;
+			w.followers.push_back(ready);
 		}
 
 		if(ready == last_writer)
@@ -1224,9 +1551,119 @@ Status DBImpl::Write(const WriteOptions& opt, WriteBatch* my_batch)
 	if(!writers_.empty())
 		writers_.front()->cv.Signal();
 
+	//memtable׶
+	if(status.ok() && w.updates != NULL)
+		status = InsertIntoMemTable(&w);
+
+	if(w.updates != NULL && w.updates != my_batch)
+		delete w.updates;
+
+	//֪ͨwriterд
+	for(size_t i = 0; i < w.followers.size(); i++){
+		Writer* ready = w.followers[i];
+		ready->status = status;
+		ready->state = Writer::kDone;
+		ready->cv.Signal();
+	}
+
 	return status;
 }
 
+//leaderдmemtableWAL˳򷢲LastSequence
+//allow_concurrent_memtable_writeʱÿwriterԲԼbatch
+//ͬд֮ҲԲ룬ֻзsequenceǰ˳
+Status DBImpl::InsertIntoMemTable(Writer* leader)
+{
+	mutex_.AssertHeld();
+
+	//¼дӦmemtablemem_Ѿл
+	leader->mem = mem_;
+	leader->mem->Ref();
+
+	memtable_writers_.push_back(leader);
+
+	Status status;
+	if(!options_.allow_concurrent_memtable_write){
+		//skiplistֵֻ֧д̣߳д֮䰴˳
+		while(leader != memtable_writers_.front())
+			leader->cv.Wait();
+
+		mutex_.Unlock();
+		//дmem table
+		status = WriteBatchInternal::InsertInto(leader->updates, leader->mem);
+		mutex_.Lock();
+	}
+	else{
+		//ϲbatchиwriterbatchģΪÿbatchøԵʼsequence
+		SequenceNumber seq = WriteBatchInternal::Sequence(leader->updates);
+		WriteBatchInternal::SetSequence(leader->batch, seq);
+		seq += WriteBatchInternal::Count(leader->batch);
+
+		leader->status = Status::OK(); //leaderstatusռfollowerĲ
+		leader->pending_inserts = 0;
+		for(size_t i = 0; i < leader->followers.size(); i++){
+			Writer* f = leader->followers[i];
+			if(f->batch == NULL)
+				continue;
+
+			WriteBatchInternal::SetSequence(f->batch, seq);
+			seq += WriteBatchInternal::Count(f->batch);
+
+			//followerԼ
+			f->leader = leader;
+			f->mem = leader->mem;
+			leader->pending_inserts ++;
+			f->cv.Signal();
+		}
+
+		mutex_.Unlock();
+		status = WriteBatchInternal::InsertInto(leader->batch, leader->mem, true);
+		mutex_.Lock();
+
+		//ȴfollowerɣǰд鶼Ѿ
+		while(leader->pending_inserts > 0 || leader != memtable_writers_.front())
+			leader->cv.Wait();
+
+		if(status.ok())
+			status = leader->status;
+	}
+
+	//ǰд鶼ѾɣԷsequence
+	versions_->SetLastSequence(leader->last_sequence);
+	leader->mem->Unref();
+	leader->mem = NULL;
+
+	memtable_writers_.pop_front();
+	if(!memtable_writers_.empty())
+		memtable_writers_.front()->cv.Signal();
+	else //MakeRoomForWriteڵȴmemtableд
+		bg_cv_.SignalAll();
+
+	return status;
+}
+
+//followerleaderѺԼbatchmemtable
+void DBImpl::FollowerInsert(Writer* w)
+{
+	mutex_.AssertHeld();
+
+	Writer* leader = w->leader;
+	MemTable* mem = w->mem;
+	w->mem = NULL;
+
+	mutex_.Unlock();
+	Status s = WriteBatchInternal::InsertInto(w->batch, mem, true);
+	mutex_.Lock();
+
+	if(!s.ok() && leader->status.ok())
+		leader->status = s;
+
+	leader->pending_inserts --;
+	if(leader->pending_inserts == 0)
+		leader->cv.Signal();
+}
+
+//ϲwriters_еĶbatchصbatchfirst->batchʱɵͷ
 WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer)
 {
 	assert(!writers_.empty());
@@ -1255,10 +1692,9 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer)
 			if(size > max_size) //պõд
 				break;
 			
-			//һbatch
+			//һbatch,ǰһܻʹһϲbatchmemtableÿ鵥
 			if(result == first->batch){
-				result = tmp_batch_;
-				assert(WriteBatchInternal::Count(result) == 0);
+				result = new WriteBatch;
 				WriteBatchInternal::Append(result, first->batch);
 			}
 
@@ -1298,6 +1734,9 @@ Status DBImpl::MakeRoomForWrite(bool force)
 			Log(options_.info_log, "Too many L0 files; waiting...\n");
 			bg_cv_.Wait();
 		}
+		else if(!memtable_writers_.empty()){ //дڲmem_ɺлmemtable־
+			bg_cv_.Wait();
+		}
 		else{ //mem tableҪתƵimm
 			assert(versions_->PrevLogNumber());
 			uint64_t new_log_number = versions_->NewFileNumber();
@@ -1317,10 +1756,11 @@ Status DBImpl::MakeRoomForWrite(bool force)
 			log_  = new log::Writer(lfile);
 			//mem_תƵimmУΪmemҪΪtable CompactļУΪ˲ӰдתƵimm
 			imm_ = mem_;
+			imm_->MarkImmutable();
 			has_imm_.Release_Store(imm_);
 
 			//´һmem table
-			mem_ = new MemTable(internal_comparator_);
+			mem_ = new MemTable(internal_comparator_, options_.memtable_factory, options_.allow_concurrent_memtable_write);
 			mem_->Ref();
 			force = false;
 
@@ -1434,6 +1874,12 @@ Status DB::Delete(const WriteOptions& opt, const Slice& key)
 	return Write(opt, &batch);
 }
 
+void DB::MultiGet(const ReadOptions& opt, const Slice* keys, int n, std::string* values, Status* statuses)
+{
+	for(int i = 0; i < n; i ++)
+		statuses[i] = Get(opt, keys[i], &values[i]);
+}
+
 DB::~DB()
 {
 
@@ -1451,6 +1897,8 @@ Status DB::Open(const Options& opt, const std::string& dbname, DB** dbptr)
 	//ȡ־ָversionmem table
 	Status s = impl->Recover(&edit);
 	if(s.ok()){
+		impl->allocated_sequence_ = impl->versions_->LastSequence();
+
 		//һ־ļ
 		uint64_t new_log_number = impl->versions_->NewFileNumber();
 		WritableFile* lfile;
@@ -3,6 +3,7 @@
 
 #include <deque>
 #include <set>
+#include <vector>
 #include "dbformat.h"
 #include "log_write.h"
 #include "snapshot.h"
@@ -13,6 +14,7 @@
 
 namespace leveldb{
 
+class Compaction;
 class MemTable;
 class TableCache;
 class Version;
@@ -30,6 +32,7 @@ public:
 	virtual Status Write(const WriteOptions& opt, WriteBatch* updates);
 
 	virtual Status Get(const ReadOptions& opt, const Slice& key, std::string* value);
+	virtual void MultiGet(const ReadOptions& opt, const Slice* keys, int n, std::string* values, Status* statuses);
 	virtual Iterator* NewIterator(const ReadOptions& opt);
 
 	virtual const Snapshot* GetSnapshot();
@@ -53,6 +56,7 @@ public:
 private:
 	friend class DB;
 	struct CompactionState;
+	struct SubcompactionTask;
 	struct Writer;
 
 	DBImpl(const DBImpl&);
@@ -78,20 +82,38 @@ private:
 
 	WriteBatch* BuildBatchGroup(Writer** last_writer);
 
+	Status InsertIntoMemTable(Writer* leader) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+	void FollowerInsert(Writer* w) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
 	void RecordBackgroundError(const Status& s);
 
 	void MaybeScheduleCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-	static void BGWork(void* db);
+	static void BGWorkFlush(void* db);
+	static void BGWorkCompaction(void* db);
 
-	void BackgroundCall();
+	void BackgroundFlushCall();
+	void BackgroundCompactionCall();
 
-	void BackgroundCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+	bool BackgroundCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+	Status LogAndApply(VersionEdit* edit) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
 	void CleanupCompaction(CompactionState* compact) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
 	Status DoCompactionWork(CompactionState* compact) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+	Status DoSubcompactions(CompactionState* compact, const std::vector<Compaction*>& shards);
+
+	Status DoCompactionShard(CompactionState* compact);
+
+	void RunSubcompactions(SubcompactionTask* task);
+
+	static void BGWorkSubcompaction(void* arg);
+
+	static void ReleaseSubcompactionTask(SubcompactionTask* task);
+
 	Status OpenCompactionOutputFile(CompactionState* compact);
 
 	Status FinishCompactionOutputFile(CompactionState* compact, Iterator* input);
@@ -127,17 +149,28 @@ private:
 	log::Writer* log_;
 	uint32_t seed_;
 
+	//ȴдWALwriter
 	std::deque<Writer*> writers_;
-	WriteBatch* tmp_batch_;
+	//ѾдWALȴ˳memtableдleader
+	std::deque<Writer*> memtable_writers_;
+	//ѾдsequenceLastSequence()ֻڲmemtableƽ
+	SequenceNumber allocated_sequence_;
 
 	SnapshotList snapshots_;
 	std::set<uint64_t> pending_outputs_;
-	bool bg_compaction_scheduled_;
+	//ѾύEnv̳߳صflushcompaction
+	int bg_flush_scheduled_;
+	int bg_compaction_scheduled_;
+	//ִDoCompactionWorktrivial moveԶcompaction
+	int bg_compaction_running_;
+	//к̨߳дMANIFEST߳Ҫȴ
+	bool manifest_writing_;
 
 	struct ManualCompaction
 	{
 		int level;
 		bool done;
+		bool in_progress;
 		const InternalKey* begin;
 		const InternalKey* end;
 		InternalKey tmp_storage;
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <vector>
 #include "dbformat.h"
 #include "port.h"
 #include "coding.h"
@@ -113,12 +114,32 @@ void InternalFilterPolicy::CreateFilter(const Slice* keys, int n, std::string* d
 	user_policy_->CreateFilter(keys, n, dst);
 }
 
+void InternalFilterPolicy::CreateFilterForLevel(const Slice* keys, int n, std::string* dst, int level) const
+{
+	Slice* mkey = const_cast<Slice*>(keys);
+	for(int i = 0; i < n; i ++){
+		mkey[i] = ExtractUserKey(keys[i]);
+	}
+
+	user_policy_->CreateFilterForLevel(keys, n, dst, level);
+}
+
 bool InternalFilterPolicy::KeyMayMatch(const Slice& key, const Slice& f) const
 {
 	//user keyй
 	return user_policy_->KeyMayMatch(ExtractUserKey(key), f);
 }
 
+void InternalFilterPolicy::KeysMayMatch(const Slice* keys, int n, const Slice& f, bool* results) const
+{
+	std::vector<Slice> user_keys(n);
+	for(int i = 0; i < n; i ++)
+		user_keys[i] = ExtractUserKey(keys[i]);
+
+	if(n > 0)
+		user_policy_->KeysMayMatch(&user_keys[0], n, f, results);
+}
+
 LookupKey::LookupKey(const Slice& user_key, SequenceNumber s)
 {
 	size_t usize = user_key.size();
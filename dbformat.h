@@ -101,7 +101,9 @@ public:
 	explicit InternalFilterPolicy(const FilterPolicy* p) : user_policy_(p) { }
 	virtual const char* name() const;
 	virtual void CreateFilter(const Slice* keys, int n, std::string* dst) const;
+	virtual void CreateFilterForLevel(const Slice* keys, int n, std::string* dst, int level) const;
 	virtual bool KeyMayMatch(const Slice& key, const Slice& filter) const;
+	virtual void KeysMayMatch(const Slice* keys, int n, const Slice& filter, bool* results) const;
 };
 
 //ڲKEY
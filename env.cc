@@ -12,6 +12,12 @@ void Log(Logger* info_log, const char* format, ...)
 	}
 }
 
+void RandomAccessFile::ReadMulti(ReadRequest* reqs, size_t num_reqs) const
+{
+	for(size_t i = 0; i < num_reqs; i ++)
+		reqs[i].status = Read(reqs[i].offset, reqs[i].len, &reqs[i].result, reqs[i].scratch);
+}
+
 //дļò
 static Status DoWriteStringToFile(Env* env, const Slice& data, const std::string& fname, bool should_sync)
 {
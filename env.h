@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include "status.h"
+#include "slice.h"
 
 namespace leveldb{
 
@@ -25,10 +26,28 @@ public:
 
 	static Env* Default();
 
+	//̨ȼHIGHmemtable flushLOWlevel compaction
+	enum Priority
+	{
+		LOW		= 0,
+		HIGH	= 1,
+		TOTAL	= 2
+	};
+
 	//ļӿ
 	virtual Status NewSequentialFile(const std::string& fname, SequentialFile** result) = 0;
 	virtual Status NewRandomAccessFile(const std::string& fname, RandomAccessFile** result) = 0;
 	virtual Status NewWritableFile(const std::string& fname, WritableFile** result) = 0;
+	//дƹϵͳpage cache(O_DIRECT)ļcompaction಻ٱȡĴIO
+	//ǰ̨Getpageȥֵ֧EnvĬϴͨļ
+	virtual Status NewDirectRandomAccessFile(const std::string& fname, RandomAccessFile** result)
+	{
+		return NewRandomAccessFile(fname, result);
+	}
+	virtual Status NewDirectWritableFile(const std::string& fname, WritableFile** result)
+	{
+		return NewWritableFile(fname, result);
+	}
 	virtual bool FileExists(const std::string& fname) = 0;
 	virtual Status GetChildren(const std::string& dir, std::vector<std::string>* result) = 0;
 	virtual Status DeleteFile(const std::string& fname) = 0;
@@ -38,7 +57,9 @@ public:
 	virtual Status RenameFile(const std::string& src, const std::string& target) = 0;
 	virtual Status LockFile(const std::string& fname, FileLock** lock) = 0;
 	virtual Status UnlockFile(FileLock* lock) = 0;
-	virtual void Schedule(void (*function)(void* arg), void* arg) = 0;
+	virtual void Schedule(void (*function)(void* arg), void* arg, Priority pri = LOW) = 0;
+	//priӦ̳߳صĺ̨߳
+	virtual void SetBackgroundThreads(int number, Priority pri = LOW) = 0;
 	virtual void StartThread(void (*function)(void* arg), void* arg) = 0;
 	virtual Status GetTestDirectory(std::string* path) = 0;
 	virtual Status NewLogger(const std::string& fname, Logger** result) = 0;
@@ -64,6 +85,20 @@ private:
 	void operator=(const SequentialFile&);
 };
 
+//RandomAccessFile::ReadMultiһoffsetlenscratchɵдresultstatusΪؽ
+struct ReadRequest
+{
+	uint64_t offset;
+	size_t len;
+	char* scratch;
+	Slice result;
+	Status status;
+	//Ϊtrueʱ첽ûȷϽں֮Կдscratch߲ͷŻ߸scratch
+	bool scratch_busy;
+
+	ReadRequest() : offset(0), len(0), scratch(NULL), scratch_busy(false){};
+};
+
 class RandomAccessFile
 {
 public:
@@ -72,6 +107,13 @@ public:
 
 	virtual Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const = 0;
 
+	//һύʵֿ԰ͬʱ豸(io_uring)ȫɺ󷵻ء
+	//ĬRead
+	virtual void ReadMulti(ReadRequest* reqs, size_t num_reqs) const;
+
+	//ʾ[offset, offset + n)ϻᱻȡʵֿǰȡĬʲô
+	virtual void Prefetch(uint64_t offset, size_t n) const {};
+
 private:
 	RandomAccessFile(const RandomAccessFile&);
 	void operator=(const RandomAccessFile&);
@@ -88,6 +130,11 @@ public:
 	virtual Status Flush() = 0;
 	virtual Status Sync() = 0;
 
+	//sizeСֿԤļռ䣬0ʾԤ䡣ʵֿԺ
+	virtual void SetPreallocationBlockSize(size_t size){};
+	//ÿдbytesֽòϵͳں̨ʼдأƽSyncʱд̣0ʾرաʵֿԺ
+	virtual void SetBytesPerSync(uint64_t bytes){};
+
 private:
 	WritableFile(const WritableFile&);
 	void operator=(const WritableFile&);
@@ -147,6 +194,16 @@ public:
 		return target_->NewWritableFile(f, r);
 	}
 
+	Status NewDirectRandomAccessFile(const std::string& f, RandomAccessFile** r)
+	{
+		return target_->NewDirectRandomAccessFile(f, r);
+	}
+
+	Status NewDirectWritableFile(const std::string& f, WritableFile** r)
+	{
+		return target_->NewDirectWritableFile(f, r);
+	}
+
 	bool FileExists(const std::string& f) 
 	{ 
 		return target_->FileExists(f); 
@@ -192,9 +249,14 @@ public:
 		return target_->UnlockFile(l); 
 	}
 
-	void Schedule(void (*f)(void*), void* a) 
+	void Schedule(void (*f)(void*), void* a, Priority pri = LOW) 
+	{
+		return target_->Schedule(f, a, pri);
+	}
+
+	void SetBackgroundThreads(int number, Priority pri = LOW)
 	{
-		return target_->Schedule(f, a);
+		return target_->SetBackgroundThreads(number, pri);
 	}
 
 	void StartThread(void (*f)(void*), void* a) 
@@ -1,5 +1,7 @@
 #include <deque>
 #include <set>
+#include <vector>
+#include <assert.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -13,6 +15,10 @@
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#ifdef LEVELDB_IO_URING
+#include <liburing.h>
+#endif
 
 
 #if defined(LEVELDB_PLATFORM_ANDROID)
@@ -35,6 +41,115 @@ static Status IOError(const std::string& context, int err_number)
 	return Status::IOError(context, strerror(err_number));
 }
 
+#ifdef LEVELDB_IO_URING
+//ÿ߳һio_uringһʱ߳˳ʱͷ
+static const unsigned kUringDepth = 64;
+static pthread_key_t uring_key;
+static pthread_once_t uring_once = PTHREAD_ONCE_INIT;
+
+static void DeleteUring(void* arg)
+{
+	struct io_uring* ring = reinterpret_cast<struct io_uring*>(arg);
+	io_uring_queue_exit(ring);
+	delete ring;
+}
+
+static void InitUringKey()
+{
+	pthread_key_create(&uring_key, DeleteUring);
+}
+
+//ں˲֧io_uringʱNULL˻صpread
+static struct io_uring* ThreadUring()
+{
+	pthread_once(&uring_once, InitUringKey);
+	struct io_uring* ring = reinterpret_cast<struct io_uring*>(pthread_getspecific(uring_key));
+	if(ring == NULL){
+		ring = new struct io_uring;
+		if(io_uring_queue_init(kUringDepth, ring, 0) != 0){
+			delete ring;
+			return NULL;
+		}
+		pthread_setspecific(uring_key, ring);
+	}
+	return ring;
+}
+
+//ͷŵǰ̳߳ringһʱ´
+static void ResetThreadUring()
+{
+	struct io_uring* ring = reinterpret_cast<struct io_uring*>(pthread_getspecific(uring_key));
+	if(ring != NULL){
+		pthread_setspecific(uring_key, NULL);
+		DeleteUring(ring);
+	}
+}
+#endif
+
+//O_DIRECTҪдļƫơȺڴַ߼С룬4KBԸǳ豸
+static const size_t kDirectIOAlignment = 4096;
+//directдĻСдԺһд
+static const size_t kDirectWriteBufferSize = 1 << 20;
+//PosixWritableFileдС
+static const size_t kWritableFileBufferSize = 256 * 1024;
+static const size_t kPageSize = 4096;
+
+static inline uint64_t TruncateToAlignment(uint64_t x)
+{
+	return x & ~static_cast<uint64_t>(kDirectIOAlignment - 1);
+}
+
+static inline uint64_t RoundUpToAlignment(uint64_t x)
+{
+	return TruncateToAlignment(x + kDirectIOAlignment - 1);
+}
+
+//ʼַkDirectIOAlignmentĻ
+class AlignedBuffer
+{
+public:
+	AlignedBuffer() : data_(NULL), capacity_(0){};
+	~AlignedBuffer()
+	{
+		free(data_);
+	}
+
+	char* data() const { return data_; };
+	size_t capacity() const { return capacity_; };
+
+	//ʱ·䣬ԭݲ
+	bool Reserve(size_t n)
+	{
+		if(n <= capacity_)
+			return true;
+
+		n = static_cast<size_t>(RoundUpToAlignment(n));
+		void* p = NULL;
+		if(posix_memalign(&p, kDirectIOAlignment, n) != 0)
+			return false;
+
+		free(data_);
+		data_ = reinterpret_cast<char*>(p);
+		capacity_ = n;
+		return true;
+	}
+
+private:
+	AlignedBuffer(const AlignedBuffer&);
+	void operator=(const AlignedBuffer&);
+
+	char* data_;
+	size_t capacity_;
+};
+
+static void PthreadCall(const char* label, int result)
+{
+	if(result != 0){
+		fprintf(stderr, "pthread %s: %s\n", label, strerror(result));
+		abort();
+	}
+}
+
 //ļ
 class PosixSequentialFile : public SequentialFile
 {
@@ -77,7 +192,7 @@ public:
 	PosixRandomAccessFile(const std::string& fname, int fd) : filename_(fname), fd_(fd){};
 	virtual ~PosixRandomAccessFile(){close(fd_);};
 
-	virtual Status Read(uint64_t offset, size_t n, Slice* result, char* scratch)
+	virtual Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const
 	{
 		Status s;
 		ssize_t r = pread(fd_, scratch, n, static_cast<off_t>(offset));
@@ -85,13 +200,243 @@ public:
 		if(r < 0){
 			s = IOError(filename_, errno);
 		}
+		return s;
 	};
 
+	//ںں̨page cache֮preadҪȴ
+	virtual void Prefetch(uint64_t offset, size_t n) const
+	{
+#if defined(__linux__)
+		posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(n), POSIX_FADV_WILLNEED);
+#endif
+	}
+
+	virtual void ReadMulti(ReadRequest* reqs, size_t num_reqs) const
+	{
+#ifdef LEVELDB_IO_URING
+		struct io_uring* ring = NULL;
+		if(num_reqs > 1 && (ring = ThreadUring()) != NULL){
+			for(size_t start = 0; start < num_reqs; start += kUringDepth){
+				const size_t count = std::min(num_reqs - start, static_cast<size_t>(kUringDepth));
+				if(!UringReadBatch(ring, reqs + start, count)){
+					//ringѾãͷŵͬ
+					ResetThreadUring();
+					RandomAccessFile::ReadMulti(reqs + start + count, num_reqs - start - count);
+					return;
+				}
+			}
+			return;
+		}
+#endif
+		RandomAccessFile::ReadMulti(reqs, num_reqs);
+	}
+
+private:
+#ifdef LEVELDB_IO_URING
+	//ringȡcount󣬷ʱÿѾꡣѾύȫոԺ
+	//ûύpreadȡں˲ڷԺдscratch
+	//ȴcqeʱȡڽе󣬼ոÿcqeΪֹ
+	//ȡԺȻȲscratch_busyɵй©scratch
+	//ringֲָܻĴ(вsqecqe)ʱfalseͷring
+	bool UringReadBatch(struct io_uring* ring, ReadRequest* reqs, size_t count) const
+	{
+		bool healthy = true;
+		size_t prepared = 0;
+		while(prepared < count){
+			//ȲСcountòsqe˵һв
+			struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+			if(sqe == NULL){
+				healthy = false;
+				break;
+			}
+			io_uring_prep_read(sqe, fd_, reqs[prepared].scratch, reqs[prepared].len, reqs[prepared].offset);
+			io_uring_sqe_set_data(sqe, &reqs[prepared]);
+			prepared ++;
+		}
+
+		//io_uring_submitֻύһ֣sqe˳ύύʣµ
+		size_t submitted = 0;
+		while(submitted < prepared){
+			const int ret = io_uring_submit(ring);
+			if(ret > 0)
+				submitted += ret;
+			else if(ret != -EINTR){
+				//ûύsqeڶringٸһʹ
+				healthy = false;
+				break;
+			}
+		}
+
+		std::vector<bool> done(count, false);
+		size_t reaped = 0;
+		bool cancelled = false;
+		while(reaped < submitted){
+			struct io_uring_cqe* cqe = NULL;
+			const int ret = io_uring_wait_cqe(ring, &cqe);
+			if(ret == -EINTR || ret == -EAGAIN)
+				continue;
+			if(ret < 0){
+				healthy = false;
+				if(!cancelled){
+					cancelled = true;
+					submitted += CancelPending(ring, reqs, submitted, prepared, done);
+					continue;
+				}
+
+				//ȡԺǵȲʣµɣǵscratchܻᱻںд룬
+				//IOҲͬͬһڴ
+				for(size_t i = 0; i < submitted; i ++){
+					if(!done[i]){
+						reqs[i].result = Slice(reqs[i].scratch, 0);
+						reqs[i].status = IOError(filename_, -ret);
+						reqs[i].scratch_busy = true;
+						done[i] = true;
+					}
+				}
+				break;
+			}
+
+			ReadRequest* req = reinterpret_cast<ReadRequest*>(io_uring_cqe_get_data(cqe));
+			const int res = cqe->res;
+			io_uring_cqe_seen(ring, cqe);
+			if(req == NULL) //ȡԼcqe
+				continue;
+			reaped ++;
+
+			if(res < 0){
+				req->result = Slice(req->scratch, 0);
+				req->status = IOError(filename_, -res);
+			}
+			else if(static_cast<size_t>(res) < req->len){
+				//̶(ļβ֮ǰж)ʣµĲͬ
+				Slice rest;
+				req->status = Read(req->offset + res, req->len - res, &rest, req->scratch + res);
+				req->result = Slice(req->scratch, res + rest.size());
+			}
+			else{
+				req->result = Slice(req->scratch, res);
+				req->status = Status::OK();
+			}
+			done[req - reqs] = true;
+		}
+
+		//ûύͬȡ
+		for(size_t i = submitted; i < count; i ++)
+			reqs[i].status = Read(reqs[i].offset, reqs[i].len, &reqs[i].result, reqs[i].scratch);
+
+		return healthy;
+	}
+
+	//Ϊ[0, submitted)лûɵύȡȡuser dataΪNULL
+	//io_uring_submitύв[submitted, prepared)бһύĸ
+	size_t CancelPending(struct io_uring* ring, ReadRequest* reqs, size_t submitted, size_t prepared, const std::vector<bool>& done) const
+	{
+		for(size_t i = 0; i < submitted; i ++){
+			if(done[i])
+				continue;
+
+			struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+			if(sqe == NULL)
+				break;
+			io_uring_prep_cancel(sqe, &reqs[i], 0);
+			io_uring_sqe_set_data(sqe, NULL);
+		}
+
+		int ret;
+		do{
+			ret = io_uring_submit(ring);
+		}while(ret == -EINTR);
+
+		if(ret <= 0)
+			return 0;
+		return std::min(static_cast<size_t>(ret), prepared - submitted);
+	}
+#endif
+
 private:
 	std::string filename_;
 	int fd_;
 };
 
+//O_DIRECT󣬶ȡƹpage cache
+//ĶչɶķΧһĻٿPrefetchԤΧ
+//֮ڷΧڵĶֱӴӻ˳ɨʱһdirectԸǺܶblock
+class PosixDirectRandomAccessFile : public RandomAccessFile
+{
+public:
+	PosixDirectRandomAccessFile(const std::string& fname, int fd)
+		: filename_(fname), fd_(fd), buffer_offset_(0), buffer_len_(0){};
+	virtual ~PosixDirectRandomAccessFile(){close(fd_);};
+
+	virtual Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const
+	{
+		MutexLock l(&mu_);
+		Status s;
+		if(!BufferCovers(offset, n))
+			s = FillBuffer(offset, n);
+
+		//ļβʱеݿܲnֽ
+		size_t avail = 0;
+		if(s.ok() && offset >= buffer_offset_ && offset < buffer_offset_ + buffer_len_)
+			avail = static_cast<size_t>(std::min<uint64_t>(n, buffer_offset_ + buffer_len_ - offset));
+
+		if(avail > 0)
+			memcpy(scratch, buffer_.data() + (offset - buffer_offset_), avail);
+		*result = Slice(scratch, avail);
+		return s;
+	}
+
+	virtual void Prefetch(uint64_t offset, size_t n) const
+	{
+		MutexLock l(&mu_);
+		if(!BufferCovers(offset, n))
+			FillBuffer(offset, n);
+	}
+
+private:
+	bool BufferCovers(uint64_t offset, size_t n) const
+	{
+		return offset >= buffer_offset_ && offset + n <= buffer_offset_ + buffer_len_;
+	}
+
+	//[offset, offset + n)ڵĶ뷶Χbuffer_ļβ֮Ĳֲbuffer_len_
+	Status FillBuffer(uint64_t offset, size_t n) const
+	{
+		const uint64_t start = TruncateToAlignment(offset);
+		const size_t len = static_cast<size_t>(RoundUpToAlignment(offset + n) - start);
+
+		buffer_len_ = 0;
+		if(!buffer_.Reserve(len))
+			return Status::IOError(filename_, "cannot allocate aligned buffer");
+
+		buffer_offset_ = start;
+		while(buffer_len_ < len){
+			ssize_t r = pread(fd_, buffer_.data() + buffer_len_, len - buffer_len_, static_cast<off_t>(start + buffer_len_));
+			if(r < 0){
+				if(errno == EINTR)
+					continue;
+				return IOError(filename_, errno);
+			}
+
+			buffer_len_ += r;
+			//ļβƫƲټdirect
+			if(r == 0 || (static_cast<size_t>(r) & (kDirectIOAlignment - 1)) != 0)
+				break;
+		}
+
+		return Status::OK();
+	}
+
+private:
+	std::string filename_;
+	int fd_;
+
+	mutable port::Mutex mu_;
+	mutable AlignedBuffer buffer_;
+	mutable uint64_t buffer_offset_;
+	mutable size_t buffer_len_;
+};
+
 //MMAP 
 class MmapLimiter
 {
@@ -169,6 +514,20 @@ public:
 		return s;
 	};
 
+	virtual void Prefetch(uint64_t offset, size_t n) const
+	{
+		if(offset >= length_)
+			return;
+		if(n > length_ - offset)
+			n = length_ - offset;
+
+		//madviseҪʼַҳ
+		const uintptr_t page = static_cast<uintptr_t>(getpagesize());
+		const uintptr_t start = reinterpret_cast<uintptr_t>(mmapped_region_) + offset;
+		const uintptr_t aligned = start & ~(page - 1);
+		madvise(reinterpret_cast<void*>(aligned), n + (start - aligned), MADV_WILLNEED);
+	}
+
 private:
 	std::string filename_;
 	void* mmapped_region_;
@@ -176,41 +535,76 @@ private:
 	MmapLimiter* limiter_;
 };
 
-class PosixWriteableFile : public WritableFile
+//дļ׷ӵԼĻFlushʱwriteд
+//԰Ԥļռ(fallocate)ÿдbytes_per_syncֽڷһ첽ķΧд(sync_file_range)
+class PosixWritableFile : public WritableFile
 {
 public:
-	PosixWriteableFile(const std::string& fname, FILE* f) : filename_(fname), file_(f){};
-	virtual ~PosixWriteableFile()
+	PosixWritableFile(const std::string& fname, int fd)
+		: filename_(fname), fd_(fd), buf_(new char[kWritableFileBufferSize]), pos_(0), filesize_(0),
+		preallocation_block_size_(0), preallocated_(0), bytes_per_sync_(0), last_sync_(0){};
+
+	virtual ~PosixWritableFile()
 	{
-		fclose(file_);
+		if(fd_ >= 0)
+			Close();
+		delete []buf_;
 	};
 
+	virtual void SetPreallocationBlockSize(size_t size)
+	{
+		preallocation_block_size_ = size;
+	}
+
+	virtual void SetBytesPerSync(uint64_t bytes)
+	{
+		bytes_per_sync_ = bytes;
+	}
+
 	virtual Status Append(const Slice& data)
 	{
-		size_t r = fwrite_unlocked(data.data(), 1, data.size(), file_);
-		if(r != data.size()){
-			return IOError(filename_, errno);
+		const char* p = data.data();
+		size_t n = data.size();
+
+		//Ⱦ뻺
+		const size_t copy = std::min(n, kWritableFileBufferSize - pos_);
+		memcpy(buf_ + pos_, p, copy);
+		p += copy;
+		n -= copy;
+		pos_ += copy;
+		if(n == 0)
+			return Status::OK();
+
+		Status s = FlushBuffer();
+		if(!s.ok())
+			return s;
+
+		//ʣµݱȻСʱ뻺ֱдһζĿ
+		if(n < kWritableFileBufferSize){
+			memcpy(buf_, p, n);
+			pos_ = n;
+			return Status::OK();
 		}
-		return Status::OK();
+		return WriteUnbuffered(p, n);
 	};
 
 	virtual Status Close()
 	{
-		Status result;
-		if(fclose(file_) != 0){
-			result = IOError(filename_, errno);
-		}
+		Status s = FlushBuffer();
+		//ͷļĩβԤ䵫ûõĿռ
+		if(preallocated_ > filesize_ && ftruncate(fd_, static_cast<off_t>(filesize_)) != 0 && s.ok())
+			s = IOError(filename_, errno);
 
-		file_ = NULL;
-		return result;
+		if(close(fd_) < 0 && s.ok())
+			s = IOError(filename_, errno);
+
+		fd_ = -1;
+		return s;
 	};
 
 	virtual Status Flush()
 	{
-		if(fflush_unlocked(file_) != 0){
-			return IOError(filename_, errno);
-		}
-		return Status::OK();
+		return FlushBuffer();
 	};
 
 	Status SyncDirIfManifest()
@@ -251,16 +645,214 @@ public:
 			return s;
 		}
 
-		if(fflush_unlocked(file_) != 0 || fdatasync(fileno(file_)) != 0) {
-			s = Status::IOError(filename_, strerror(errno));
+		s = FlushBuffer();
+		if(s.ok()){
+			if(fdatasync(fd_) != 0)
+				s = IOError(filename_, errno);
+			else
+				last_sync_ = filesize_;
 		}
 
 		return s;
 	}
 
+private:
+	Status FlushBuffer()
+	{
+		Status s = WriteUnbuffered(buf_, pos_);
+		pos_ = 0;
+		return s;
+	}
+
+	Status WriteUnbuffered(const char* data, size_t n)
+	{
+		if(n == 0)
+			return Status::OK();
+
+		Preallocate(filesize_ + n);
+		while(n > 0){
+			ssize_t r = write(fd_, data, n);
+			if(r < 0){
+				if(errno == EINTR)
+					continue;
+				return IOError(filename_, errno);
+			}
+			data += r;
+			n -= r;
+			filesize_ += r;
+		}
+
+		return RangeSync();
+	}
+
+	//preallocation_block_size_һһεԤ䣬ļϵͳƬÿ׷ʱԪݸ¡
+	//FALLOC_FL_KEEP_SIZEıļȣCloseʱصĲ
+	void Preallocate(uint64_t end)
+	{
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+		if(preallocation_block_size_ == 0 || end <= preallocated_)
+			return;
+
+		const uint64_t block = preallocation_block_size_;
+		const uint64_t new_end = (end + block - 1) / block * block;
+		if(fallocate(fd_, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(preallocated_), static_cast<off_t>(new_end - preallocated_)) == 0)
+			preallocated_ = new_end;
+		else //ļϵͳ֧֣ٳ
+			preallocation_block_size_ = 0;
+#endif
+	}
+
+	//ÿдbytes_per_sync_ֽڣں˿ʼһҳдش̵ȴɣ
+	//ҳһֱ۵Syncһдӳë
+	Status RangeSync()
+	{
+#if defined(__linux__)
+		if(bytes_per_sync_ == 0 || filesize_ - last_sync_ < bytes_per_sync_)
+			return Status::OK();
+
+		//һҳ֮󻹻ᱻдһ
+		const uint64_t end = filesize_ & ~static_cast<uint64_t>(kPageSize - 1);
+		if(end <= last_sync_)
+			return Status::OK();
+
+		if(sync_file_range(fd_, static_cast<off_t>(last_sync_), static_cast<off_t>(end - last_sync_), SYNC_FILE_RANGE_WRITE) != 0)
+			return IOError(filename_, errno);
+		last_sync_ = end;
+#endif
+		return Status::OK();
+	}
+
 private:
 	std::string filename_;
-	FILE* file_;
+	int fd_;
+	char* buf_;
+	size_t pos_;						//buf_ддֽ
+	uint64_t filesize_;					//Ѿдļֽ
+	size_t preallocation_block_size_;
+	uint64_t preallocated_;
+	uint64_t bytes_per_sync_;
+	uint64_t last_sync_;				//λ֮ǰѾд
+};
+
+//O_DIRECTд׷ӵĻֻдĶ顣
+//SyncCloseʱһβ0дٰļضϵʵʵĳȣ
+//βȻڻ֮Appendͬһдһ
+class PosixDirectWritableFile : public WritableFile
+{
+public:
+	PosixDirectWritableFile(const std::string& fname, int fd)
+		: filename_(fname), fd_(fd), file_offset_(0), buffered_(0)
+	{
+		buffer_.Reserve(kDirectWriteBufferSize);
+	}
+
+	virtual ~PosixDirectWritableFile()
+	{
+		if(fd_ >= 0)
+			Close();
+	}
+
+	virtual Status Append(const Slice& data)
+	{
+		if(buffer_.data() == NULL)
+			return Status::IOError(filename_, "cannot allocate aligned buffer");
+
+		const char* p = data.data();
+		size_t left = data.size();
+		while(left > 0){
+			const size_t n = std::min(left, buffer_.capacity() - buffered_);
+			memcpy(buffer_.data() + buffered_, p, n);
+			buffered_ += n;
+			p += n;
+			left -= n;
+
+			if(buffered_ == buffer_.capacity()){
+				Status s = WriteAligned();
+				if(!s.ok())
+					return s;
+			}
+		}
+
+		return Status::OK();
+	}
+
+	virtual Status Close()
+	{
+		Status s = WriteTail();
+		if(close(fd_) < 0 && s.ok())
+			s = IOError(filename_, errno);
+
+		fd_ = -1;
+		return s;
+	}
+
+	//һβܵdirectдSync/Close
+	virtual Status Flush()
+	{
+		return WriteAligned();
+	}
+
+	virtual Status Sync()
+	{
+		Status s = WriteTail();
+		if(s.ok() && fdatasync(fd_) != 0)
+			s = IOError(filename_, errno);
+		return s;
+	}
+
+private:
+	Status WriteRaw(const char* data, size_t n, uint64_t offset)
+	{
+		while(n > 0){
+			ssize_t r = pwrite(fd_, data, n, static_cast<off_t>(offset));
+			if(r < 0){
+				if(errno == EINTR)
+					continue;
+				return IOError(filename_, errno);
+			}
+			data += r;
+			n -= r;
+			offset += r;
+		}
+		return Status::OK();
+	}
+
+	//дĲ֣ʣµβƵͷ
+	Status WriteAligned()
+	{
+		const size_t aligned = static_cast<size_t>(TruncateToAlignment(buffered_));
+		if(aligned == 0)
+			return Status::OK();
+
+		Status s = WriteRaw(buffer_.data(), aligned, file_offset_);
+		if(s.ok()){
+			file_offset_ += aligned;
+			memmove(buffer_.data(), buffer_.data() + aligned, buffered_ - aligned);
+			buffered_ -= aligned;
+		}
+		return s;
+	}
+
+	//дݣβ
+	Status WriteTail()
+	{
+		Status s = WriteAligned();
+		if(!s.ok() || buffered_ == 0)
+			return s;
+
+		memset(buffer_.data() + buffered_, 0, kDirectIOAlignment - buffered_);
+		s = WriteRaw(buffer_.data(), kDirectIOAlignment, file_offset_);
+		if(s.ok() && ftruncate(fd_, static_cast<off_t>(file_offset_ + buffered_)) != 0)
+			s = IOError(filename_, errno);
+		return s;
+	}
+
+private:
+	std::string filename_;
+	int fd_;
+	AlignedBuffer buffer_;
+	uint64_t file_offset_;		//buffer_[0]ӦļƫƣǶ
+	size_t buffered_;
 };
 
 static int LockOrUnlock(int fd, bool lock) 
@@ -358,17 +950,51 @@ public:
 	}
 
 	//д
-	virtual Status NewWriteableFile(const std::string& fname, WritableFile** result)
+	virtual Status NewWritableFile(const std::string& fname, WritableFile** result)
 	{
 		Status s;
-		FILE* f = fopen(fname.c_str(), "w");
-		if(f == NULL){
+		int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(fd < 0){
 			*result = NULL;
 			s = IOError(fname, errno);
 		}
 		else{
-			*result = new PosixWriteableFile(fname, f);
+			*result = new PosixWritableFile(fname, fd);
+		}
+		return s;
+	}
+
+	//ļϵͳ֧O_DIRECT(tmpfsEINVAL)ʱ˻صͨļ
+	virtual Status NewDirectRandomAccessFile(const std::string& fname, RandomAccessFile** result)
+	{
+#ifdef O_DIRECT
+		int fd = open(fname.c_str(), O_RDONLY | O_DIRECT);
+		if(fd >= 0){
+			*result = new PosixDirectRandomAccessFile(fname, fd);
+			return Status::OK();
 		}
+		if(errno != EINVAL){
+			*result = NULL;
+			return IOError(fname, errno);
+		}
+#endif
+		return NewRandomAccessFile(fname, result);
+	}
+
+	virtual Status NewDirectWritableFile(const std::string& fname, WritableFile** result)
+	{
+#ifdef O_DIRECT
+		int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+		if(fd >= 0){
+			*result = new PosixDirectWritableFile(fname, fd);
+			return Status::OK();
+		}
+		if(errno != EINVAL){
+			*result = NULL;
+			return IOError(fname, errno);
+		}
+#endif
+		return NewWritableFile(fname, result);
 	}
 
 	virtual bool FileExists(const std::string& fname)
@@ -484,7 +1110,8 @@ public:
 		return result;
 	}
 
-	virtual void Schedule(void (*function)(void*), void* arg);
+	virtual void Schedule(void (*function)(void*), void* arg, Priority pri);
+	virtual void SetBackgroundThreads(int num, Priority pri);
 	virtual void StartThread(void (*function)(void* arg), void* arg);
 
 	virtual Status GetTestDirectory(std::string* result) 
@@ -537,58 +1164,103 @@ public:
 	}
 
 private:
-	void BGThread();
-
-	static void* BGThreadWrapper(void* arg)
+	//̨̳߳أÿȼӦһ̳߳أHIGHmemtable flushLOWcompaction
+	//һʱlevel compactionimm_д
+	class ThreadPool
 	{
-		reinterpret_cast<PosixEnv*>(arg)->BGThread();
-		return NULL;
-	}
+	public:
+		ThreadPool() : total_threads_limit_(1)
+		{
+			PthreadCall("mutex_init", pthread_mutex_init(&mu_, NULL));
+			PthreadCall("cvar_init", pthread_cond_init(&bgsignal_, NULL));
+		}
+
+		void Schedule(void (*function)(void*), void* arg);
+		void SetBackgroundThreads(int num);
+
+	private:
+		void StartThreadsIfNeeded();
+		void BGThread();
+
+		static void* BGThreadWrapper(void* arg)
+		{
+			reinterpret_cast<ThreadPool*>(arg)->BGThread();
+			return NULL;
+		}
+
+	private:
+		pthread_mutex_t mu_;
+		pthread_cond_t bgsignal_;
+		std::vector<pthread_t> bgthreads_;
+		int total_threads_limit_;
+
+		struct BGItem {void* arg; void (*function)(void*);};
+		typedef std::deque<BGItem> BGQueue;
+		BGQueue queue_;
+	};
 
 private:
-	pthread_mutex mu_;
-	pthread_cond_t bgsignal_;
-	pthread_t bgthread_;
-	bool started_bgthread_;
-
-	struct BGItem {void* arg; void (*function)(void*);};
-	typedef std::queue<BGItem> BGQueue;
-	BGQueue queue_;
+	ThreadPool thread_pools_[Env::TOTAL];
 	PosixLockTable locks_;
 	MmapLimiter mmap_limit_;
 };
 
-PosixEnv::PosixEnv() : started_bgthread_(false) 
+PosixEnv::PosixEnv()
+{
+}
+
+void PosixEnv::Schedule(void (*function)(void*), void* arg, Priority pri) 
 {
-	PthreadCall("mutex_init", pthread_mutex_init(&mu_, NULL));
-	PthreadCall("cvar_init", pthread_cond_init(&bgsignal_, NULL));
+	assert(pri >= LOW && pri < TOTAL);
+	thread_pools_[pri].Schedule(function, arg);
 }
 
-void PosixEnv::Schedule(void (*function)(void*), void* arg) 
+void PosixEnv::SetBackgroundThreads(int num, Priority pri)
+{
+	assert(pri >= LOW && pri < TOTAL);
+	thread_pools_[pri].SetBackgroundThreads(num);
+}
+
+//ֻ̳߳󲻻СDBEnv::Default()ʱȡ
+void PosixEnv::ThreadPool::SetBackgroundThreads(int num)
 {
 	PthreadCall("lock", pthread_mutex_lock(&mu_));
+	if(num > total_threads_limit_)
+		total_threads_limit_ = num;
+	//ѾŶӣ߳
+	if(!queue_.empty())
+		StartThreadsIfNeeded();
+	PthreadCall("unlock", pthread_mutex_unlock(&mu_));
+}
 
-	// Start background thread if necessary
-	if (!started_bgthread_) {
-		started_bgthread_ = true;
-		PthreadCall("create thread", pthread_create(&bgthread_, NULL,  &PosixEnv::BGThreadWrapper, this));
+void PosixEnv::ThreadPool::StartThreadsIfNeeded()
+{
+	while(static_cast<int>(bgthreads_.size()) < total_threads_limit_){
+		pthread_t t;
+		PthreadCall("create thread", pthread_create(&t, NULL, &ThreadPool::BGThreadWrapper, this));
+		bgthreads_.push_back(t);
 	}
+}
 
-	// If the queue is currently empty, the background thread may currently be
-	// waiting.
-	if (queue_.empty()) {
-		PthreadCall("signal", pthread_cond_signal(&bgsignal_));
-	}
+void PosixEnv::ThreadPool::Schedule(void (*function)(void*), void* arg) 
+{
+	PthreadCall("lock", pthread_mutex_lock(&mu_));
+
+	// Start background threads if necessary
+	StartThreadsIfNeeded();
 
 	// Add to priority queue
 	queue_.push_back(BGItem());
 	queue_.back().function = function;
 	queue_.back().arg = arg;
 
+	//ж߳ڵȴһ
+	PthreadCall("signal", pthread_cond_signal(&bgsignal_));
+
 	PthreadCall("unlock", pthread_mutex_unlock(&mu_));
 }
 
-void PosixEnv::BGThread() 
+void PosixEnv::ThreadPool::BGThread() 
 {
 	while(true) {
 		PthreadCall("lock", pthread_mutex_lock(&mu_));
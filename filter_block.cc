@@ -4,16 +4,14 @@
 
 namespace leveldb{
 
-static const size_t kFilterBaseLg = 11; 
-static const size_t kFilterBase = 1 << kFilterBaseLg; //2KB
-
-FilterBlockBuilder::FilterBlockBuilder(const FilterPolicy* p) : policy_(p)
+//Ĭÿ2KBһfilter
+FilterBlockBuilder::FilterBlockBuilder(const FilterPolicy* p, size_t base_lg, int level) : policy_(p), base_lg_(base_lg), level_(level)
 {
 }
 
 void FilterBlockBuilder::StartBlock(uint64_t block_offset)
 {
-	uint64_t filter_index = (block_offset / kFilterBase);
+	uint64_t filter_index = (block_offset >> base_lg_);
 	assert(filter_index >= filter_offsets_.size());
 	while(filter_index > filter_offsets_.size()){ //ÿ2Kһfilter
 		GenerateFilter();
@@ -39,7 +37,7 @@ Slice FilterBlockBuilder::Finish()
 	}
 
 	PutFixed32(&result_, array_offset); //ձݳдresult,4ֽ
-	result_.push_back(kFilterBaseLg); //1ֽ
+	result_.push_back(static_cast<char>(base_lg_)); //1ֽ
 
 	return Slice(result_);
 }
@@ -63,7 +61,7 @@ void FilterBlockBuilder::GenerateFilter()
 	}
 
 	filter_offsets_.push_back(result_.size());
-	policy_->CreateFilter(&tmp_keys_[0], num_keys, &result_); //һձ
+	policy_->CreateFilterForLevel(&tmp_keys_[0], num_keys, &result_, level_); //һձ
 
 	//չձĲ
 	tmp_keys_.clear();
@@ -107,5 +105,68 @@ bool FilterBlockReader::KeyMayMatch(uint64_t block_offset, const Slice& key)
 }
 
 
+void FilterBlockReader::KeysMayMatch(uint64_t block_offset, const Slice* keys, int n, bool* results)
+{
+	uint64_t index = block_offset >> base_lg_;
+	if(index < num_){
+		uint32_t start = DecodeFixed32(offset_ + index * 4);
+		uint32_t limit = DecodeFixed32(offset_ + index * 4 + 4);
+		if(start <= limit && limit <= (offset_ - data_)){
+			policy_->KeysMayMatch(keys, n, Slice(data_ + start, limit - start), results);
+			return;
+		}
+		else if(start == limit){
+			for(int i = 0; i < n; i ++)
+				results[i] = false;
+			return;
+		}
+	}
+
+	for(int i = 0; i < n; i ++)
+		results[i] = true;
+}
+
+FullFilterBlockBuilder::FullFilterBlockBuilder(const FilterPolicy* p, int level) : policy_(p), level_(level)
+{
+}
+
+void FullFilterBlockBuilder::AddKey(const Slice& key)
+{
+	start_.push_back(keys_.size());
+	keys_.append(key.data(), key.size());
+}
+
+Slice FullFilterBlockBuilder::Finish()
+{
+	result_.clear();
+	const size_t num_keys = start_.size();
+	if(num_keys == 0)
+		return Slice(result_);
+
+	start_.push_back(keys_.size());
+	tmp_keys_.resize(num_keys);
+	for(size_t i = 0; i < num_keys; i ++)
+		tmp_keys_[i] = Slice(keys_.data() + start_[i], start_[i + 1] - start_[i]);
+
+	policy_->CreateFilterForLevel(&tmp_keys_[0], num_keys, &result_, level_);
+	return Slice(result_);
+}
+
+void FullFilterBlockBuilder::Reset()
+{
+	tmp_keys_.clear();
+	keys_.clear();
+	start_.clear();
+	result_.clear();
+}
+
+bool FullFilterBlockReader::KeyMayMatch(const Slice& key)
+{
+	//յĹʾûκkey
+	if(contents_.empty())
+		return false;
+	return policy_->KeyMayMatch(key, contents_);
+}
+
 }//leveldb
 
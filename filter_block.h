@@ -12,10 +12,15 @@ namespace leveldb{
 
 class FilterPolicy;
 
+//base_lgȡֵʱκblock offsetڵ0ϣtableֻһ
+static const size_t kWholeTableFilterBaseLg = 63;
+
 class FilterBlockBuilder
 {
 public:
-	explicit FilterBlockBuilder(const FilterPolicy*);
+	//base_lgΪÿǵļΧ(2^base_lgֽ)kWholeTableFilterBaseLgʾtableһ
+	//levelΪtableҪдĲ㣬FilterPolicy::CreateFilterForLevel
+	explicit FilterBlockBuilder(const FilterPolicy*, size_t base_lg = 11, int level = -1);
 
 	void StartBlock(uint64_t block_offset);
 	void AddKey(const Slice& key);
@@ -31,6 +36,8 @@ private:
 
 private:
 	const FilterPolicy* policy_;
+	const size_t base_lg_;
+	const int level_;
 	std::string keys_;
 	std::vector<size_t> start_;
 	std::string result_;
@@ -43,6 +50,11 @@ class FilterBlockReader
 public:
 	FilterBlockReader(const FilterPolicy*policy, const Slice& contents);
 	bool KeyMayMatch(uint64_t block_offset, const Slice& key);
+	//ͬһblock offsetĹжnkey
+	void KeysMayMatch(uint64_t block_offset, const Slice* keys, int n, bool* results);
+
+	//tableֻһԲindexֱжkey
+	bool whole_table() const { return base_lg_ >= kWholeTableFilterBaseLg; };
 
 private:
 	const FilterPolicy* policy_;
@@ -52,6 +64,43 @@ private:
 	size_t base_lg_;
 };
 
+//һkeyһĹblock offsetֶΡڷÿindexӦһ
+class FullFilterBlockBuilder
+{
+public:
+	explicit FullFilterBlockBuilder(const FilterPolicy*, int level = -1);
+
+	void AddKey(const Slice& key);
+	bool empty() const { return start_.empty(); };
+
+	//صSliceһReset֮ǰЧ
+	Slice Finish();
+	void Reset();
+
+private:
+	FullFilterBlockBuilder(const FullFilterBlockBuilder&);
+	void operator=(const FullFilterBlockBuilder&);
+
+private:
+	const FilterPolicy* policy_;
+	const int level_;
+	std::string keys_;
+	std::vector<size_t> start_;
+	std::string result_;
+	std::vector<Slice> tmp_keys_;
+};
+
+class FullFilterBlockReader
+{
+public:
+	FullFilterBlockReader(const FilterPolicy* policy, const Slice& contents) : policy_(policy), contents_(contents){};
+	bool KeyMayMatch(const Slice& key);
+
+private:
+	const FilterPolicy* policy_;
+	Slice contents_;
+};
+
 }//leveldb
 
 #endif
@@ -1,8 +1,11 @@
 #ifndef __FILTER_POLICY_H_
 #define __FILTER_POLICY_H_
 
+#include <string>
+#include <vector>
+#include "slice.h"
+
 namespace leveldb{
-class Slice;
 
 //ӿ
 class FilterPolicy
@@ -12,12 +15,43 @@ public:
 	virtual const char* name() const = 0;
 	//һ
 	virtual void CreateFilter(const Slice* keys, int n, std::string* dst) const = 0;
+	//ΪleveltablelevelΪ-1ʾȷĬϺͲ޹أ
+	//԰ʹòͬȵʵֱѾȱڹУΪtableڲ֮ƶʱؽ
+	virtual void CreateFilterForLevel(const Slice* keys, int n, std::string* dst, int level) const
+	{
+		CreateFilter(keys, n, dst);
+	}
 	//ݹ˷
 	virtual bool KeyMayMatch(const Slice& key, const Slice& filter) const = 0;
+
+	//ͬһ̽nkeyдresults[0..n-1]
+	//ĬKeyMayMatchʵֿԤȡkeyλڸcache miss
+	virtual void KeysMayMatch(const Slice* keys, int n, const Slice& filter, bool* results) const
+	{
+		for(int i = 0; i < n; i ++)
+			results[i] = KeyMayMatch(keys[i], filter);
+	}
 };
 
 extern const FilterPolicy* NewBloomFilterPolicy(int bits_per_key);
 
+//64ֽڷֿbloomһkeykbitͬһ64ֽڵĿڣÿֻ̽һcache line
+//ͬbits_per_keyԸNewBloomFilterPolicyʺtableһ(Options::whole_table_filter)
+extern const FilterPolicy* NewBlockedBloomFilterPolicy(int bits_per_key);
+
+//ͬϣkeyhashHash6432λѡline32λlineڵλãkeyhash۸͡
+//ֲͬNewBlockedBloomFilterPolicyɵĹܻȡ
+extern const FilterPolicy* NewBlockedBloomFilterPolicy64(int bits_per_key);
+
+//binary fuse(xorĸĽ)Լ1.125 * (bits_per_key / 1.125ȡ) bits/keyԼ2^-(bits_per_key / 1.125)
+//ͬʱbloomʡ20%~30%Ŀռ䡣Ҫһkeyȥغһη룬
+//ʺOptions::whole_table_filterpartition_index_and_filtersʹ
+extern const FilterPolicy* NewFuseFilterPolicy(int bits_per_key);
+
+//þȣlevel_bits_per_key[i]ڵi㣬Ĳʹһֵ
+//{10, 10, 8, 7}ڵ²øٵڴ
+extern const FilterPolicy* NewFuseFilterPolicy(const std::vector<int>& level_bits_per_key);
+
 };
 
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "format.h"
+#include <vector>
 #include "env.h"
 #include "port.h"
 #include "block.h"
@@ -65,8 +66,89 @@ Status Footer::DecodeFrom(Slice* input)
 	}
 }
 
+static bool GetUncompressedLength(CompressionType type, const char* data, size_t n, size_t* ulength)
+{
+	switch(type){
+	case kSnappyCompression:
+		return port::Snappy_GetUncompressedLength(data, n, ulength);
+	case kLZ4Compression:
+		return port::LZ4_GetUncompressedLength(data, n, ulength);
+	case kZstdCompression:
+		return port::Zstd_GetUncompressedLength(data, n, ulength);
+	default:
+		return false;
+	}
+}
+
+static bool Uncompress(CompressionType type, const char* data, size_t n, char* ubuf, size_t ulength, void* zstd_dict)
+{
+	switch(type){
+	case kSnappyCompression:
+		return port::Snappy_Uncompress(data, n, ubuf);
+	case kLZ4Compression:
+		return port::LZ4_Uncompress(data, n, ubuf, ulength);
+	case kZstdCompression:
+		if(zstd_dict != NULL)
+			return port::Zstd_UncompressWithDict(zstd_dict, data, n, ubuf, ulength);
+		return port::Zstd_Uncompress(data, n, ubuf, ulength);
+	default:
+		return false;
+	}
+}
+
+static Status DecodeBlock(const ReadOptions& options, size_t n, const Slice& contents, char* buf, BlockContents* result,
+	void* zstd_dict, std::string* raw);
+
+//ѹdata[0, n)typeΪѹͣheapϷ
+static Status UncompressData(CompressionType type, const char* data, size_t n, BlockContents* result, void* zstd_dict)
+{
+	size_t ulength = 0;
+	if(!GetUncompressedLength(type, data, n, &ulength)) //ѹ
+		return Status::Corruption("corrupted compressed block contents");
+
+	//ݽѹ
+	char* ubuf = new char[ulength];
+	if(!Uncompress(type, data, n, ubuf, ulength, zstd_dict)){
+		delete []ubuf;
+		return Status::Corruption("corrupted compressed block contents");
+	}
+
+	result->data = Slice(ubuf, ulength);
+	result->heap_allocated = true;
+	result->cachable = true;
+	return Status::OK();
+}
+
+Status UncompressBlockContents(const Slice& raw, BlockContents* result, void* zstd_dict)
+{
+	result->data = Slice();
+	result->cachable = false;
+	result->heap_allocated = false;
+	if(raw.empty())
+		return Status::Corruption("bad compressed block contents");
+
+	const size_t n = raw.size() - 1;
+	switch(raw[n]){
+	case kNoCompression:{
+			char* buf = new char[n];
+			memcpy(buf, raw.data(), n);
+			result->data = Slice(buf, n);
+			result->heap_allocated = true;
+			result->cachable = true;
+			return Status::OK();
+		}
+	case kSnappyCompression:
+	case kLZ4Compression:
+	case kZstdCompression:
+		return UncompressData(static_cast<CompressionType>(raw[n]), raw.data(), n, result, zstd_dict);
+	default:
+		return Status::Corruption("bad block type");
+	}
+}
+
 //block handleļжȡһblockڴ
-Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const BlockHandle& handle, BlockContents* result)
+Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const BlockHandle& handle, BlockContents* result, void* zstd_dict,
+	std::string* raw)
 {
 	result->data = Slice();
 	result->cachable = false;
@@ -82,6 +164,52 @@ Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const Block
 		return s;
 	}
 
+	return DecodeBlock(options, n, contents, buf, result, zstd_dict, raw);
+}
+
+//ȡblockĶһνRandomAccessFile::ReadMulti
+void ReadBlocks(RandomAccessFile* file, const ReadOptions& options, const BlockHandle* handles, size_t num, BlockContents* results, Status* statuses,
+	void* zstd_dict, std::string* raw)
+{
+	std::vector<ReadRequest> reqs(num);
+	for(size_t i = 0; i < num; i ++){
+		results[i].data = Slice();
+		results[i].cachable = false;
+		results[i].heap_allocated = false;
+
+		reqs[i].offset = handles[i].offset();
+		reqs[i].len = static_cast<size_t>(handles[i].size()) + kBlockTrailerSize;
+		reqs[i].scratch = new char[reqs[i].len];
+	}
+
+	if(num > 0)
+		file->ReadMulti(&reqs[0], num);
+
+	for(size_t i = 0; i < num; i ++){
+		statuses[i] = reqs[i].status;
+		if(!statuses[i].ok()){
+			//ں˿ܻдscratchֻй©ͷԺƻϵ
+			if(!reqs[i].scratch_busy)
+				delete []reqs[i].scratch;
+			continue;
+		}
+
+		statuses[i] = DecodeBlock(options, static_cast<size_t>(handles[i].size()), reqs[i].result, reqs[i].scratch, &results[i],
+			zstd_dict, raw != NULL ? &raw[i] : NULL);
+	}
+}
+
+//contentsΪblockݼtrailerbufΪȡʱʹõĻӹܡ
+//rawΪNULLʱblockݺͿraw
+static Status DecodeBlock(const ReadOptions& options, size_t n, const Slice& contents, char* buf, BlockContents* result,
+	void* zstd_dict, std::string* raw)
+{
+	Status s;
+	if(contents.size() != n + kBlockTrailerSize){
+		delete []buf;
+		return Status::Corruption("truncated block read");
+	}
+
 	const char* data = contents.data();
 	if(options.verfy_checksums){
 		const uint32_t crc = crc32c::Unmask(DecodeFixed32(data + n + 1)); //CRC
@@ -95,6 +223,8 @@ Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const Block
 
 	switch(data[n]){
 	case kNoCompression: //ѹ
+		if(raw != NULL)
+			raw->assign(data, n + 1);
 		if(data != buf){ //MMAPģʽ
 			delete []buf;
 			result->data = Slice(data, n);
@@ -108,26 +238,15 @@ Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const Block
 		}
 		break;
 
-	case kSnappyCompression:{ //snappyѹ
-			size_t ulength = 0;
-			if(!port::Snappy_GetUncompressedLength(data, n, &ulength)){ //snappy ѹ
-				delete []buf;
-				return Status::Corruption("corrupted compressed block contents");
-			}
-
-			//ݽѹ
-			char* ubuf = new char[ulength];
-			if(!port::Snappy_Uncompress((data, n, ubuf))){
-				delete []buf;
-				delete []ubuf;
-				return Status::Corruption("corrupted compressed block contents");
-			}
-
+	case kSnappyCompression: //snappyѹ
+	case kLZ4Compression:
+	case kZstdCompression:{
+			s = UncompressData(static_cast<CompressionType>(data[n]), data, n, result, zstd_dict);
+			if(s.ok() && raw != NULL)
+				raw->assign(data, n + 1);
 			delete []buf;
-
-			result->data = Slice(ubuf, ulength);
-			result->heap_allocated = true;
-			result->cachable = true;
+			if(!s.ok())
+				return s;
 		}
 		break;
 
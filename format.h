@@ -73,8 +73,21 @@ struct BlockContents{
 	bool	heap_allocated;		//true,表示数据可以被delete[]进行内存释放
 };
 
-//从file中读取一个BLOCK,
-extern Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const BlockHandle& handle, BlockContents* result);
+//table中记录ZSTD字典的meta block在meta index中的key
+static const char kCompressionDictBlockName[] = "compression.dict";
+
+//从file中读取一个BLOCK, zstd_dict为table的ZSTD字典(port::Zstd_NewUncompressDict)，只有data block使用。
+//raw不为NULL时，*raw为block在文件中的原始数据(数据 + 1字节压缩类型，不含CRC)，
+//用于放入压缩block cache和持久化cache
+extern Status ReadBlock(RandomAccessFile* file, const ReadOptions& options, const BlockHandle& handle, BlockContents* result,
+	void* zstd_dict = NULL, std::string* raw = NULL);
+
+//一次读取num个block，读请求通过RandomAccessFile::ReadMulti同时提交，results[i]、statuses[i]、raw[i]对应handles[i]
+extern void ReadBlocks(RandomAccessFile* file, const ReadOptions& options, const BlockHandle* handles, size_t num,
+	BlockContents* results, Status* statuses, void* zstd_dict = NULL, std::string* raw = NULL);
+
+//解码ReadBlock输出的原始数据，压缩的block解压，没有压缩的block拷贝一份，结果都在heap上
+extern Status UncompressBlockContents(const Slice& raw, BlockContents* result, void* zstd_dict);
 
 inline BlockHandle::BlockHandle() : offset_(~static_cast<uint64_t>(0)), size_(~static_cast<uint64_t>(0))
 {
@@ -0,0 +1,282 @@
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "filter_policy.h"
+#include "slice.h"
+#include "hash.h"
+#include "coding.h"
+
+namespace leveldb{
+
+//3·binary fuse(xorĸĽ)
+//ÿkeyӳ䵽3segmentе3λ3λָkeyָƣ
+//ռԼΪ1.125 * fingerprint_bits bits/keyԼΪ2^-fingerprint_bits
+//bloom10 bits/keyʱԼ1%7λָƵ0.78%ֻҪԼ8 bits/key
+//
+//洢ṹ|ָ(fingerprint_bits)|4ֽ|seed(4ֽ)|segment_length(4ֽ)|segment_count_length(4ֽ)|fingerprint_bits(1ֽ)|
+//
+//ʱÿkeyֻܳһΣkeyʱ̶ϴʺtable߷Ĺ
+//(Options::whole_table_filter / partition_index_and_filters)ʺĬϵÿ2KBһ
+static const size_t kFuseTrailerSize = 13;
+static const int kFuseMaxFingerprintBits = 24;
+static const int kFuseMaxAttempts = 64;
+
+namespace {
+
+struct FuseLayout
+{
+	uint32_t segment_length;
+	uint32_t segment_count_length;
+
+	uint32_t array_length() const { return segment_count_length + 2 * segment_length; };
+
+	//һkey3λ[0, segment_count_length)ѡһڵsegment
+	void Positions(uint64_t h, uint32_t pos[3]) const
+	{
+		const uint32_t mask = segment_length - 1;
+		pos[0] = static_cast<uint32_t>(((h >> 32) * segment_count_length) >> 32);
+		pos[1] = (pos[0] + segment_length) ^ (static_cast<uint32_t>(h >> 18) & mask);
+		pos[2] = (pos[0] + 2 * segment_length) ^ (static_cast<uint32_t>(h) & mask);
+	}
+};
+
+//64λhashٴtablehashײɵĹʧ
+static uint64_t FuseKeyHash(const Slice& key)
+{
+	return Hash64(key.data(), key.size(), 0xbc9f1d34);
+}
+
+static inline uint64_t FuseMix(uint64_t h, uint64_t seed)
+{
+	h += seed;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline uint32_t FuseFingerprint(uint64_t h, int bits)
+{
+	return static_cast<uint32_t>(h ^ (h >> 32)) & ((1u << bits) - 1);
+}
+
+//keyѡsegmentСܲλbinary fuse
+static FuseLayout ComputeLayout(uint32_t n)
+{
+	const double size = n < 2 ? 2.0 : static_cast<double>(n);
+	uint32_t segment_length = 1u << static_cast<int>(floor(log(size) / log(3.33) + 2.25));
+	if(segment_length > (1u << 18))
+		segment_length = 1u << 18;
+
+	const double factor = std::max(1.125, 0.875 + 0.25 * log(1000000.0) / log(size));
+	const uint32_t capacity = n <= 1 ? 0 : static_cast<uint32_t>(floor(n * factor + 0.5));
+	//capacityСʱ޷Żƺһеļӷ
+	const uint32_t init_segment_count = (capacity + segment_length - 1) / segment_length - 2;
+	const uint32_t array_length = (init_segment_count + 2) * segment_length;
+	uint32_t segment_count = (array_length + segment_length - 1) / segment_length;
+	segment_count = segment_count <= 2 ? 1 : segment_count - 2;
+
+	FuseLayout layout;
+	layout.segment_length = segment_length;
+	layout.segment_count_length = segment_count * segment_length;
+	return layout;
+}
+
+//ָưbitsλУ24λдʱ4ֽڣ4ֽ
+static inline uint32_t GetFingerprint(const char* array, uint32_t i, int bits)
+{
+	const uint64_t bit_offset = static_cast<uint64_t>(i) * bits;
+	const uint32_t word = DecodeFixed32(array + bit_offset / 8);
+	return (word >> (bit_offset % 8)) & ((1u << bits) - 1);
+}
+
+static inline void SetFingerprint(char* array, uint32_t i, int bits, uint32_t v)
+{
+	const uint64_t bit_offset = static_cast<uint64_t>(i) * bits;
+	const uint64_t shifted = static_cast<uint64_t>(v) << (bit_offset % 8);
+	unsigned char* p = reinterpret_cast<unsigned char*>(array + bit_offset / 8);
+	for(int b = 0; b < 4; b ++)
+		p[b] |= static_cast<unsigned char>(shifted >> (8 * b));
+}
+
+};
+
+class FuseFilterPolicy : public FilterPolicy
+{
+public:
+	//level_bits_per_key[i]Ϊibits_per_keyĲʹһֵȷĲ(-1)ʹõһֵ
+	explicit FuseFilterPolicy(const std::vector<int>& level_bits_per_key)
+	{
+		for(size_t i = 0; i < level_bits_per_key.size(); i ++){
+			int bits = static_cast<int>(level_bits_per_key[i] / 1.125);
+			if(bits < 1)
+				bits = 1;
+			else if(bits > kFuseMaxFingerprintBits)
+				bits = kFuseMaxFingerprintBits;
+			fingerprint_bits_.push_back(bits);
+		}
+
+		if(fingerprint_bits_.empty())
+			fingerprint_bits_.push_back(8);
+	}
+
+	virtual const char* name() const
+	{
+		return "leveldb.BinaryFuseFilter";
+	}
+
+	virtual void CreateFilter(const Slice* keys, int n, std::string* dst) const
+	{
+		CreateFilterForLevel(keys, n, dst, -1);
+	}
+
+	virtual void CreateFilterForLevel(const Slice* keys, int n, std::string* dst, int level) const
+	{
+		int bits = fingerprint_bits_[0];
+		if(level >= 0)
+			bits = fingerprint_bits_[std::min(static_cast<size_t>(level), fingerprint_bits_.size() - 1)];
+
+		//ͬһuser keyĶ汾ظ֣ͬhash޷룬ȥ
+		std::vector<uint64_t> hashes(n);
+		for(int i = 0; i < n; i ++)
+			hashes[i] = FuseKeyHash(keys[i]);
+		std::sort(hashes.begin(), hashes.end());
+		hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+		const FuseLayout layout = ComputeLayout(static_cast<uint32_t>(hashes.size()));
+		const uint32_t array_length = layout.array_length();
+		const size_t array_bytes = (static_cast<uint64_t>(array_length) * bits + 7) / 8 + 4;
+
+		const size_t init_size = dst->size();
+		dst->resize(init_size + array_bytes, 0);
+
+		uint32_t seed = 0;
+		std::vector<std::pair<uint64_t, uint32_t> > order;
+		for(int attempt = 0; attempt < kFuseMaxAttempts; attempt ++, seed ++){
+			if(Peel(hashes, layout, seed, &order))
+				break;
+		}
+
+		if(order.size() != hashes.size()){
+			//Сʹʧܣдһfingerprint_bitsΪ0Ĺʱȫܴ
+			bits = 0;
+		}
+		else{
+			//ֵ֤ÿkey3ָָ
+			char* array = &(*dst)[init_size];
+			for(size_t i = order.size(); i > 0; i --){
+				const uint64_t h = order[i - 1].first;
+				const uint32_t slot = order[i - 1].second;
+				uint32_t pos[3];
+				layout.Positions(h, pos);
+
+				uint32_t fp = FuseFingerprint(h, bits);
+				for(int j = 0; j < 3; j ++){
+					if(pos[j] != slot)
+						fp ^= GetFingerprint(array, pos[j], bits);
+				}
+				SetFingerprint(array, slot, bits, fp);
+			}
+		}
+
+		PutFixed32(dst, seed);
+		PutFixed32(dst, layout.segment_length);
+		PutFixed32(dst, layout.segment_count_length);
+		dst->push_back(static_cast<char>(bits));
+	}
+
+	virtual bool KeyMayMatch(const Slice& key, const Slice& filter) const
+	{
+		const size_t len = filter.size();
+		if(len < kFuseTrailerSize)
+			return true;
+
+		const char* trailer = filter.data() + len - kFuseTrailerSize;
+		const int bits = static_cast<unsigned char>(trailer[12]);
+		if(bits == 0 || bits > kFuseMaxFingerprintBits)
+			return true;
+
+		FuseLayout layout;
+		const uint32_t seed = DecodeFixed32(trailer);
+		layout.segment_length = DecodeFixed32(trailer + 4);
+		layout.segment_count_length = DecodeFixed32(trailer + 8);
+		if(layout.segment_length == 0 || (layout.segment_length & (layout.segment_length - 1)) != 0)
+			return true;
+
+		const uint64_t array_bytes = (static_cast<uint64_t>(layout.array_length()) * bits + 7) / 8 + 4;
+		if(array_bytes != len - kFuseTrailerSize)
+			return true;
+
+		const uint64_t h = FuseMix(FuseKeyHash(key), seed);
+		uint32_t pos[3];
+		layout.Positions(h, pos);
+
+		const char* array = filter.data();
+		const uint32_t fp = GetFingerprint(array, pos[0], bits) ^ GetFingerprint(array, pos[1], bits) ^ GetFingerprint(array, pos[2], bits);
+		return fp == FuseFingerprint(h, bits);
+	}
+
+private:
+	//룺ȡֻһkeyռõĲλkeyǵorderвλȥ
+	//keyܱʱɹorder[i]Ϊ(Ϻhash, keyռĲλ)
+	static bool Peel(const std::vector<uint64_t>& hashes, const FuseLayout& layout, uint32_t seed,
+					std::vector<std::pair<uint64_t, uint32_t> >* order)
+	{
+		const uint32_t array_length = layout.array_length();
+		std::vector<uint64_t> xor_hash(array_length, 0);
+		std::vector<uint32_t> count(array_length, 0);
+
+		uint32_t pos[3];
+		for(size_t i = 0; i < hashes.size(); i ++){
+			const uint64_t h = FuseMix(hashes[i], seed);
+			layout.Positions(h, pos);
+			for(int j = 0; j < 3; j ++){
+				xor_hash[pos[j]] ^= h;
+				count[pos[j]] ++;
+			}
+		}
+
+		std::vector<uint32_t> queue;
+		for(uint32_t i = 0; i < array_length; i ++){
+			if(count[i] == 1)
+				queue.push_back(i);
+		}
+
+		order->clear();
+		while(!queue.empty()){
+			const uint32_t slot = queue.back();
+			queue.pop_back();
+			if(count[slot] != 1)
+				continue;
+
+			const uint64_t h = xor_hash[slot];
+			order->push_back(std::make_pair(h, slot));
+			layout.Positions(h, pos);
+			for(int j = 0; j < 3; j ++){
+				xor_hash[pos[j]] ^= h;
+				count[pos[j]] --;
+				if(count[pos[j]] == 1)
+					queue.push_back(pos[j]);
+			}
+		}
+
+		return order->size() == hashes.size();
+	}
+
+private:
+	std::vector<int> fingerprint_bits_;
+};
+
+const FilterPolicy* NewFuseFilterPolicy(int bits_per_key)
+{
+	return new FuseFilterPolicy(std::vector<int>(1, bits_per_key));
+}
+
+const FilterPolicy* NewFuseFilterPolicy(const std::vector<int>& level_bits_per_key)
+{
+	return new FuseFilterPolicy(level_bits_per_key);
+}
+
+};
@@ -8,7 +8,7 @@
 
 namespace leveldb{
 //HASH
-uint32_t Hash(const char* data, size_t size_t n, uint32_t seed)
+uint32_t Hash(const char* data, size_t n, uint32_t seed)
 {
 	const uint32_t m = 0xc6a4a793;
 	const uint32_t r = 24;
@@ -39,6 +39,167 @@ uint32_t Hash(const char* data, size_t size_t n, uint32_t seed)
 
 	return h;
 }
+
+static const uint64_t kPrime64_1 = 0x9E3779B185EBCA87ull;
+static const uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t kPrime64_3 = 0x165667B19E3779F9ull;
+static const uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t kPrime64_5 = 0x27D4EB2F165667C5ull;
+static const uint32_t kPrime32_1 = 0x9E3779B1u;
+
+//xxh3secret1664λ
+static const uint64_t kHashKeys[16] = {
+	0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+	0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull,
+	0xcb00c391bb52283cull, 0xa32e531b8b65d088ull, 0x4ef90da297486471ull, 0xd8acdea946ef1938ull,
+	0x3f349ce33f76faa8ull, 0x1d4f0bc7c7bbdcf9ull, 0x3159b4cd4be0518aull, 0x647378d9c97e9fc8ull
+};
+
+static const size_t kStripeLen = 64;
+static const size_t kStripesPerScramble = 16;
+
+static inline uint64_t Fetch64(const char* p)
+{
+	return DecodeFixed64(p);
+}
+
+//64x64128λ˻ߵ64λ
+static inline uint64_t Mul128Fold64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	const __uint128_t r = static_cast<__uint128_t>(a) * b;
+	return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+	const uint64_t lo_lo = (a & 0xffffffffull) * (b & 0xffffffffull);
+	const uint64_t hi_lo = (a >> 32) * (b & 0xffffffffull);
+	const uint64_t lo_hi = (a & 0xffffffffull) * (b >> 32);
+	const uint64_t hi_hi = (a >> 32) * (b >> 32);
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffffull) + lo_hi;
+	const uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	const uint64_t lower = (cross << 32) | (lo_lo & 0xffffffffull);
+	return lower ^ upper;
+#endif
+}
+
+static inline uint64_t Avalanche(uint64_t h)
+{
+	h ^= h >> 37;
+	h *= 0x165667919E3779F9ull;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t Mix16(const char* p, const uint64_t* keys, uint64_t seed)
+{
+	return Mul128Fold64(Fetch64(p) ^ (keys[0] + seed), Fetch64(p + 8) ^ (keys[1] - seed));
 }
 
+//0~16ֽڣȷΣÿù̶Ķͳ˷
+static uint64_t Hash64Short(const char* p, size_t n, uint64_t seed)
+{
+	if(n > 8){
+		const uint64_t lo = Fetch64(p) ^ (kHashKeys[0] + seed);
+		const uint64_t hi = Fetch64(p + n - 8) ^ (kHashKeys[1] - seed);
+		const uint64_t acc = n + ((lo >> 32) | (lo << 32)) + hi + Mul128Fold64(lo, hi);
+		return Avalanche(acc);
+	}
+
+	if(n >= 4){
+		const uint64_t lo = DecodeFixed32(p);
+		const uint64_t hi = DecodeFixed32(p + n - 4);
+		uint64_t h = (lo << 32) + hi;
+		h ^= (kHashKeys[2] ^ kHashKeys[3]) - seed;
+		h ^= ((h >> 49) | (h << 15)) ^ ((h >> 24) | (h << 40));
+		h *= 0x9FB21C651E98DF25ull;
+		h ^= (h >> 35) + n;
+		h *= 0x9FB21C651E98DF25ull;
+		return h ^ (h >> 28);
+	}
+
+	if(n > 0){
+		const uint32_t c1 = static_cast<unsigned char>(p[0]);
+		const uint32_t c2 = static_cast<unsigned char>(p[n >> 1]);
+		const uint32_t c3 = static_cast<unsigned char>(p[n - 1]);
+		const uint32_t combined = (c1 << 16) | (c2 << 24) | c3 | (static_cast<uint32_t>(n) << 8);
+		const uint64_t keyed = combined ^ ((kHashKeys[4] & 0xffffffffull) + seed);
+		return Avalanche(keyed * kPrime64_1);
+	}
+
+	return Avalanche(seed ^ kHashKeys[5]);
+}
 
+//17~128ֽڣͷмÿȡ16ֽ
+static uint64_t Hash64Medium(const char* p, size_t n, uint64_t seed)
+{
+	uint64_t acc = n * kPrime64_1;
+	if(n > 32){
+		if(n > 64){
+			if(n > 96){
+				acc += Mix16(p + 48, kHashKeys + 12, seed);
+				acc += Mix16(p + n - 64, kHashKeys + 14, seed);
+			}
+			acc += Mix16(p + 32, kHashKeys + 8, seed);
+			acc += Mix16(p + n - 48, kHashKeys + 10, seed);
+		}
+		acc += Mix16(p + 16, kHashKeys + 4, seed);
+		acc += Mix16(p + n - 32, kHashKeys + 6, seed);
+	}
+	acc += Mix16(p, kHashKeys, seed);
+	acc += Mix16(p + n - 16, kHashKeys + 2, seed);
+	return Avalanche(acc);
+}
+
+//һstripe8ۼ8ֽڣ໥֮û
+static inline void Accumulate(uint64_t* acc, const char* p, size_t key_offset, uint64_t seed)
+{
+	for(size_t i = 0; i < 8; i ++){
+		const uint64_t data = Fetch64(p + 8 * i);
+		const uint64_t key = data ^ (kHashKeys[(i + key_offset) & 15] + seed);
+		acc[i ^ 1] += data;
+		acc[i] += (key & 0xffffffffull) * (key >> 32);
+	}
+}
+
+static inline void Scramble(uint64_t* acc)
+{
+	for(size_t i = 0; i < 8; i ++){
+		uint64_t a = acc[i];
+		a ^= a >> 47;
+		a ^= kHashKeys[(i + 8) & 15];
+		acc[i] = a * kPrime32_1;
+	}
+}
+
+static uint64_t Hash64Long(const char* p, size_t n, uint64_t seed)
+{
+	uint64_t acc[8] = {
+		kPrime32_1, kPrime64_1, kPrime64_2, kPrime64_3,
+		kPrime64_4, kPrime32_1 ^ 0x5bd1e995u, kPrime64_5, kPrime32_1 ^ 0x3c6ef372u
+	};
+
+	const size_t num_stripes = (n - 1) / kStripeLen;
+	for(size_t s = 0; s < num_stripes; s ++){
+		Accumulate(acc, p + s * kStripeLen, s % kStripesPerScramble, seed);
+		if(s % kStripesPerScramble == kStripesPerScramble - 1)
+			Scramble(acc);
+	}
+
+	//64ֽڣܺǰһstripeص
+	Accumulate(acc, p + n - kStripeLen, 7, seed);
+
+	uint64_t result = n * kPrime64_1;
+	for(size_t i = 0; i < 4; i ++)
+		result += Mul128Fold64(acc[2 * i] ^ kHashKeys[2 * i + 3], acc[2 * i + 1] ^ kHashKeys[2 * i + 4]);
+	return Avalanche(result);
+}
+
+uint64_t Hash64(const char* data, size_t n, uint64_t seed)
+{
+	if(n <= 16)
+		return Hash64Short(data, n, seed);
+	else if(n <= 128)
+		return Hash64Medium(data, n, seed);
+	return Hash64Long(data, n, seed);
+}
+
+}
@@ -6,7 +6,12 @@
 
 namespace leveldb{
 
-extern uint32_t Hash(const char* data, size_t size_t n, uint32_t seed);
+extern uint32_t Hash(const char* data, size_t n, uint32_t seed);
+
+//64λhashṹxxh3keyֳȶδkey64ֽһstripe8ۼ
+//԰stripeѭxxh3ֻڲʹã
+//ѽдϣ޸㷨޸Ĺĸʽ
+extern uint64_t Hash64(const char* data, size_t n, uint64_t seed);
 
 }
 
@@ -0,0 +1,201 @@
+#include <new>
+#include "memtablerep.h"
+#include "dbformat.h"
+#include "skiplist.h"
+#include "arena.h"
+#include "coding.h"
+#include "hash.h"
+#include "port.h"
+
+namespace leveldb{
+
+//user keyǰ׺ɢеrepÿͰһ
+//ͰڹʱһηãͰеڵһβʱCASԲԲ
+class HashSkipListRep : public MemTableRep
+{
+public:
+	HashSkipListRep(const MemTableRep::KeyComparator& cmp, Arena* arena, size_t prefix_length, size_t bucket_count);
+
+	virtual void Insert(const char* entry);
+	virtual void InsertConcurrently(const char* entry);
+	virtual bool Contains(const char* entry) const;
+	virtual size_t ApproximateMemoryUsage();
+	virtual void Get(const LookupKey& k, void* arg, bool (*callback)(void* arg, const char* entry));
+	virtual MemTableRep::Iterator* GetIterator();
+
+	virtual ~HashSkipListRep();
+
+private:
+	typedef SkipList<const char*, const MemTableRep::KeyComparator&> Bucket;
+
+	class Iterator;
+
+	//user keyǰprefix_length_ֽڣʱȡuser key
+	Slice GetPrefix(const Slice& internal_key) const
+	{
+		Slice user_key = ExtractUserKey(internal_key);
+		return Slice(user_key.data(), user_key.size() < prefix_length_ ? user_key.size() : prefix_length_);
+	}
+
+	Slice GetEntryPrefix(const char* entry) const
+	{
+		uint32_t len;
+		const char* p = GetVarint32Ptr(entry, entry + 5, &len);
+		return GetPrefix(Slice(p, len));
+	}
+
+	size_t GetHash(const Slice& prefix) const
+	{
+		return Hash(prefix.data(), prefix.size(), 0) % bucket_count_;
+	}
+
+	Bucket* GetBucket(size_t i) const
+	{
+		return reinterpret_cast<Bucket*>(buckets_[i].Acquire_Load());
+	}
+
+	Bucket* GetInitializedBucket(const Slice& prefix, bool concurrent);
+
+private:
+	const MemTableRep::KeyComparator& compare_;
+	const size_t prefix_length_;
+	const size_t bucket_count_;
+	port::AtomicPointer* buckets_;
+};
+
+HashSkipListRep::HashSkipListRep(const MemTableRep::KeyComparator& cmp, Arena* arena, size_t prefix_length, size_t bucket_count)
+	: MemTableRep(arena), compare_(cmp), prefix_length_(prefix_length), bucket_count_(bucket_count > 0 ? bucket_count : 1)
+{
+	buckets_ = new port::AtomicPointer[bucket_count_];
+	for(size_t i = 0; i < bucket_count_; i ++)
+		buckets_[i].NoBarrier_Store(NULL);
+}
+
+HashSkipListRep::~HashSkipListRep()
+{
+	//Ͱеͽڵ㶼arenaУmemtableһͷţûҪĳԱ
+	delete []buckets_;
+}
+
+HashSkipListRep::Bucket* HashSkipListRep::GetInitializedBucket(const Slice& prefix, bool concurrent)
+{
+	size_t i = GetHash(prefix);
+	Bucket* bucket = GetBucket(i);
+	if(bucket != NULL)
+		return bucket;
+
+	char* mem = concurrent ? arena_->AllocateAlignedConcurrent(sizeof(Bucket)) : arena_->AllocateAligned(sizeof(Bucket));
+	Bucket* created = new (mem) Bucket(compare_, arena_, concurrent);
+	if(!concurrent){
+		buckets_[i].Release_Store(created);
+		return created;
+	}
+
+	//߳̿ͬʱͰCASʧʱʹöԷģԼͷarena
+	if(buckets_[i].CompareAndSwap(NULL, created))
+		return created;
+	return GetBucket(i);
+}
+
+void HashSkipListRep::Insert(const char* entry)
+{
+	GetInitializedBucket(GetEntryPrefix(entry), false)->Insert(entry);
+}
+
+void HashSkipListRep::InsertConcurrently(const char* entry)
+{
+	GetInitializedBucket(GetEntryPrefix(entry), true)->InsertConcurrently(entry);
+}
+
+bool HashSkipListRep::Contains(const char* entry) const
+{
+	Bucket* bucket = GetBucket(GetHash(GetEntryPrefix(entry)));
+	return bucket != NULL && bucket->Contains(entry);
+}
+
+size_t HashSkipListRep::ApproximateMemoryUsage()
+{
+	//Ͱ鲻arena
+	return bucket_count_ * sizeof(port::AtomicPointer);
+}
+
+//ͬһuser keyа汾ǰ׺ͬһͬһͰУֻҪһ
+void HashSkipListRep::Get(const LookupKey& k, void* arg, bool (*callback)(void* arg, const char* entry))
+{
+	Bucket* bucket = GetBucket(GetHash(GetPrefix(k.internal_key())));
+	if(bucket == NULL)
+		return;
+
+	Bucket::Iterator iter(bucket);
+	for(iter.Seek(k.memtable_key().data()); iter.Valid() && callback(arg, iter.key()); iter.Next()){
+	}
+}
+
+//ȫĵͰentryϲһʱУarena
+class HashSkipListRep::Iterator : public MemTableRep::Iterator
+{
+public:
+	Iterator(Arena* arena, Bucket* list) : arena_(arena), iter_(list){};
+
+	virtual ~Iterator()
+	{
+		delete arena_;
+	}
+
+	virtual bool Valid() const { return iter_.Valid(); };
+	virtual const char* key() const { return iter_.key(); };
+	virtual void Next() { iter_.Next(); };
+	virtual void Prev() { iter_.Prev(); };
+	virtual void Seek(const char* target) { iter_.Seek(target); };
+	virtual void SeekToFirst() { iter_.SeekToFirst(); };
+	virtual void SeekToLast() { iter_.SeekToLast(); };
+
+private:
+	Arena* arena_;
+	Bucket::Iterator iter_;
+};
+
+MemTableRep::Iterator* HashSkipListRep::GetIterator()
+{
+	Arena* arena = new Arena();
+	Bucket* list = new (arena->AllocateAligned(sizeof(Bucket))) Bucket(compare_, arena);
+	for(size_t i = 0; i < bucket_count_; i ++){
+		Bucket* bucket = GetBucket(i);
+		if(bucket == NULL)
+			continue;
+
+		Bucket::Iterator iter(bucket);
+		for(iter.SeekToFirst(); iter.Valid(); iter.Next())
+			list->Insert(iter.key());
+	}
+
+	return new Iterator(arena, list);
+}
+
+class HashSkipListRepFactory : public MemTableRepFactory
+{
+public:
+	HashSkipListRepFactory(size_t prefix_length, size_t bucket_count)
+		: prefix_length_(prefix_length), bucket_count_(bucket_count){};
+
+	virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp, Arena* arena)
+	{
+		return new HashSkipListRep(cmp, arena, prefix_length_, bucket_count_);
+	}
+
+	virtual const char* Name() const { return "HashSkipListRepFactory"; };
+
+	virtual bool IsInsertConcurrentlySupported() const { return true; };
+
+private:
+	size_t prefix_length_;
+	size_t bucket_count_;
+};
+
+MemTableRepFactory* NewHashSkipListRepFactory(size_t prefix_length, size_t bucket_count)
+{
+	return new HashSkipListRepFactory(prefix_length, bucket_count);
+}
+
+};//leveldb
+
@@ -15,15 +15,29 @@ static Slice GetLengthPrefixedSlice(const char* data)
 	return Slice(p, len);
 }
 
+MemTable::MemTable(const InternalKeyComparator& cmp, MemTableRepFactory* factory, bool concurrent)
+	: comparator_(cmp), refs_(0), arena_(concurrent)
+{
+	if(factory == NULL)
+		factory = DefaultMemTableRepFactory();
+	table_ = factory->CreateMemTableRep(comparator_, &arena_);
+}
+
 MemTable::~MemTable()
 {
 	assert(refs_ == 0);
+	delete table_;
 }
 
-//ܵڴ
+//ܵڴreparena֮Լڴ
 size_t MemTable::ApproximateMemoryUsage()
 {
-	return arena_.MemoryUsage();
+	return arena_.MemoryUsage() + table_->ApproximateMemoryUsage();
+}
+
+void MemTable::MarkImmutable()
+{
+	table_->MarkReadOnly();
 }
 
 int MemTable::KeyComparator::operator()(const char* aptr, const char* bptr) const
@@ -46,24 +60,25 @@ static const char* EncodeKey(std::string* scratch, const Slice& target)
 class MemTableIterator : public Iterator
 {
 public:
-	explicit MemTableIterator(MemTable::Table* table) : iter_(table){};
+	explicit MemTableIterator(MemTableRep* table) : iter_(table->GetIterator()){};
+	virtual ~MemTableIterator() { delete iter_; };
 
-	virtual bool Valid() const {return iter_.Valid();};
+	virtual bool Valid() const {return iter_->Valid();};
 	
-	virtual void Seek(const Slice& k) {iter_.Seek(EncodeKey(&tmp_, k));};
-	virtual void SeekToFirst(){iter_.SeekToFirst();};
-	virtual void SeekToLast(){iter_.SeekToLast();};
-	virtual void Next() {iter_.Next();};
-	virtual void Prev() {iter_.Prev();};
+	virtual void Seek(const Slice& k) {iter_->Seek(EncodeKey(&tmp_, k));};
+	virtual void SeekToFirst(){iter_->SeekToFirst();};
+	virtual void SeekToLast(){iter_->SeekToLast();};
+	virtual void Next() {iter_->Next();};
+	virtual void Prev() {iter_->Prev();};
 
 	virtual Slice key() const
 	{
-		return GetLengthPrefixedSlice(iter_.key());
+		return GetLengthPrefixedSlice(iter_->key());
 	}
 
 	virtual Slice value() const
 	{
-		Slice key_slice = GetLengthPrefixedSlice(iter_.key());
+		Slice key_slice = GetLengthPrefixedSlice(iter_->key());
 		return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
 	}
 
@@ -74,23 +89,23 @@ private:
 	void operator=(const MemTableIterator&);
 
 private:
-	MemTable::Table::Iterator iter_; //ĵ
+	MemTableRep::Iterator* iter_; //repĵ
 	std::string tmp_;
 };
 
 Iterator* MemTable::NewIterator()
 {
-	return new MemTableIterator(&table_);
+	return new MemTableIterator(table_);
 }
 
-void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key, const Slice& value)
+void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key, const Slice& value, bool allow_concurrent)
 {
 	size_t key_size = key.size();
 	size_t val_size = value.size();
 	size_t internal_key_size = key_size + 8; //seq + type
 	const size_t encode_len = VarintLength(internal_key_size) + internal_key_size + VarintLength(val_size) + val_size;
 	//һkey + value
-	char* buf = arena_.Allocate(encode_len);
+	char* buf = allow_concurrent ? arena_.AllocateConcurrent(encode_len) : arena_.Allocate(encode_len);
 	char* p = EncodeVarint32(buf, internal_key_size);
 	memcpy(p, key.data(), key_size);
 	p += key_size;
@@ -99,48 +114,68 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key, const Sli
 	p = EncodeVarint32(p, val_size);
 	memcpy(p, value.data(), val_size);
 	//ԳȽм
-	assert((p + val_size) - buf == encoded_len);
+	assert((p + val_size) - buf == encode_len);
 	//ֵkey_size + key + seq + value_size + value뵽ڴ
-	table_.Insert(buf);
+	if(allow_concurrent)
+		table_->InsertConcurrently(buf);
+	else
+		table_->Insert(buf);
 }
 
-bool MemTable::Get(const LookupKey& key, std::string* value, Status* s)
+struct MemTableSaver
 {
-	Slice memkey = key.memtable_key();
-	Table::Iterator iter(&table_);
-	
-	//λkeyӦiter
-	iter.Seek(memkey.data());
-	if(iter.Valid()){
-		const char* entry = iter.key();
-		uint32_t key_length;
-		//KEYĳ
-		const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
-		//Ƚuser key
-		if(comparator_.comparator.user_comparator()->Compare(Slice(key_ptr, key_length - 8), key.user_key()) == 0){
-			//seq + type
-			const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
-			//type
-			switch(static_cast<ValueType>(tag & 0xff))
+	const Comparator* user_comparator;
+	const LookupKey* key;
+	std::string* value;
+	Status* s;
+	bool found;
+};
+
+//repӵһ>=keyentryʼصֻҪһentry
+static bool SaveValue(void* arg, const char* entry)
+{
+	MemTableSaver* saver = reinterpret_cast<MemTableSaver*>(arg);
+	uint32_t key_length;
+	//KEYĳ
+	const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+	//Ƚuser key
+	if(saver->user_comparator->Compare(Slice(key_ptr, key_length - 8), saver->key->user_key()) == 0){
+		//seq + type
+		const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+		//type
+		switch(static_cast<ValueType>(tag & 0xff))
+		{
+		case kTypeValue:
 			{
-			case kTypeValue:
-				{
-					Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
-					value->assign(v.data(), v.size());
-					return true;
-				} 
-
-			case kTypeDeletion: //ɾ
-				*s = Status::NotFound(Slice());
-				return true;
-			}
+				Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+				saver->value->assign(v.data(), v.size());
+				saver->found = true;
+				break;
+			} 
+
+		case kTypeDeletion: //ɾ
+			*(saver->s) = Status::NotFound(Slice());
+			saver->found = true;
+			break;
 		}
 	}
 
 	return false;
 }
 
-};//leveldb
-
+bool MemTable::Get(const LookupKey& key, std::string* value, Status* s)
+{
+	MemTableSaver saver;
+	saver.user_comparator = comparator_.comparator.user_comparator();
+	saver.key = &key;
+	saver.value = value;
+	saver.s = s;
+	saver.found = false;
+
+	//λһ>=keyentry
+	table_->Get(key, &saver, SaveValue);
+	return saver.found;
+}
 
+};//leveldb
 
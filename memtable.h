@@ -4,7 +4,7 @@
 #include <string>
 #include "db.h"
 #include "dbformat.h"
-#include "skiplist.h"
+#include "memtablerep.h"
 #include "arena.h"
 #include "iterator.h"
 
@@ -17,7 +17,8 @@ class MemTableIterator;
 class MemTable
 {
 public:
-	explicit MemTable(const InternalKeyComparator& comparator);
+	//factoryΪNULLʱʹĬϵconcurrentΪtrueʱAddԲ
+	MemTable(const InternalKeyComparator& comparator, MemTableRepFactory* factory, bool concurrent = false);
 
 	void Ref(){ ++refs_; };
 	void Unref() 
@@ -32,10 +33,14 @@ public:
 
 	Iterator* NewIterator();
 	
-	void Add(SequenceNumber seq, ValueType type, const Slice& key, const Slice& value);
+	//allow_concurrentΪtrueʱԺ̵߳Addִ
+	void Add(SequenceNumber seq, ValueType type, const Slice& key, const Slice& value, bool allow_concurrent = false);
 
 	bool Get(const LookupKey& key, std::string* value, Status* s);
 
+	//memtableתΪimm_ã֮󲻻Add
+	void MarkImmutable();
+
 private:
 	~MemTable(); //ùUnrefͷ
 
@@ -43,23 +48,21 @@ private:
 	void operator=(const MemTable&);
 
 private:
-	struct KeyComparator
+	struct KeyComparator : public MemTableRep::KeyComparator
 	{
 		const InternalKeyComparator comparator;
 		explicit KeyComparator(const InternalKeyComparator& c) : comparator(c){};
-		int operator()(const char* a, const char* b) const;
+		virtual int operator()(const char* a, const char* b) const;
 	};
 
 	friend class MemTableIterator;
 	friend class MemTableBackwardIterator;
-	
-	//ڴ
-	typedef SkipList<const char*, KeyComparator> Table;
 
 	 KeyComparator comparator_;
 	 int refs_;
 	 Arena arena_;
-	 Table table_;
+	 //ڴеĴ洢ṹOptions::memtable_factoryĬ
+	 MemTableRep* table_;
 };
 
 };//leveldb
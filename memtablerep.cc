@@ -0,0 +1,107 @@
+#include "memtablerep.h"
+#include "dbformat.h"
+#include "skiplist.h"
+#include "arena.h"
+
+namespace leveldb{
+
+//ĬϵGetȫĵλһ>=kentryȻ˳ص
+void MemTableRep::Get(const LookupKey& k, void* arg, bool (*callback)(void* arg, const char* entry))
+{
+	Iterator* iter = GetIterator();
+	for(iter->Seek(k.memtable_key().data()); iter->Valid() && callback(arg, iter->key()); iter->Next()){
+	}
+	delete iter;
+}
+
+//ĬϵrepentryֱΪkey
+class SkipListRep : public MemTableRep
+{
+public:
+	SkipListRep(const MemTableRep::KeyComparator& cmp, Arena* arena)
+		: MemTableRep(arena), skip_list_(cmp, arena){};
+
+	virtual void Insert(const char* entry)
+	{
+		skip_list_.Insert(entry);
+	}
+
+	virtual void InsertConcurrently(const char* entry)
+	{
+		skip_list_.InsertConcurrently(entry);
+	}
+
+	virtual bool Contains(const char* entry) const
+	{
+		return skip_list_.Contains(entry);
+	}
+
+	//ֱSeekҪĵ
+	virtual void Get(const LookupKey& k, void* arg, bool (*callback)(void* arg, const char* entry))
+	{
+		Table::Iterator iter(&skip_list_);
+		for(iter.Seek(k.memtable_key().data()); iter.Valid() && callback(arg, iter.key()); iter.Next()){
+		}
+	}
+
+	class Iterator : public MemTableRep::Iterator
+	{
+	public:
+		explicit Iterator(const SkipList<const char*, const MemTableRep::KeyComparator&>* list) : iter_(list){};
+
+		virtual bool Valid() const { return iter_.Valid(); };
+		virtual const char* key() const { return iter_.key(); };
+		virtual void Next() { iter_.Next(); };
+		virtual void Prev() { iter_.Prev(); };
+		virtual void Seek(const char* target) { iter_.Seek(target); };
+		virtual void SeekToFirst() { iter_.SeekToFirst(); };
+		virtual void SeekToLast() { iter_.SeekToLast(); };
+
+	private:
+		SkipList<const char*, const MemTableRep::KeyComparator&>::Iterator iter_;
+	};
+
+	virtual MemTableRep::Iterator* GetIterator()
+	{
+		return new Iterator(&skip_list_);
+	}
+
+private:
+	typedef SkipList<const char*, const MemTableRep::KeyComparator&> Table;
+	Table skip_list_;
+};
+
+class SkipListRepFactory : public MemTableRepFactory
+{
+public:
+	virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp, Arena* arena)
+	{
+		return new SkipListRep(cmp, arena);
+	}
+
+	virtual const char* Name() const { return "SkipListFactory"; };
+
+	virtual bool IsInsertConcurrentlySupported() const { return true; };
+};
+
+MemTableRepFactory* NewSkipListRepFactory()
+{
+	return new SkipListRepFactory();
+}
+
+static port::OnceType default_factory_once = LEVELDB_ONCE_INIT;
+static MemTableRepFactory* default_factory = NULL;
+
+static void InitDefaultFactory()
+{
+	default_factory = new SkipListRepFactory();
+}
+
+MemTableRepFactory* DefaultMemTableRepFactory()
+{
+	port::InitOnce(&default_factory_once, InitDefaultFactory);
+	return default_factory;
+}
+
+};//leveldb
+
@@ -0,0 +1,111 @@
+#ifndef __LEVEL_DB_MEMTABLEREP_H_
+#define __LEVEL_DB_MEMTABLEREP_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include "slice.h"
+
+namespace leveldb{
+
+class Arena;
+class LookupKey;
+
+//memtableڲĴ洢ṹӿڣĬ
+//entrymemtableļ¼varint32(internal key) + internal key + varint32(value) + value
+class MemTableRep
+{
+public:
+	//ȽentryĴС
+	class KeyComparator
+	{
+	public:
+		virtual ~KeyComparator(){};
+		virtual int operator()(const char* a, const char* b) const = 0;
+	};
+
+	explicit MemTableRep(Arena* arena) : arena_(arena){};
+	virtual ~MemTableRep(){};
+
+	//һentryentryڴarena䣬֤߱ͬһentryظ
+	virtual void Insert(const char* entry) = 0;
+
+	//߳ͬʱ룬ֻIsInsertConcurrentlySupported()ΪtruerepŻᱻ
+	virtual void InsertConcurrently(const char* entry)
+	{
+		assert(false);
+		Insert(entry);
+	}
+
+	virtual bool Contains(const char* entry) const = 0;
+
+	//memtableתΪimm_֮󲻻д
+	virtual void MarkReadOnly(){};
+
+	//reparena֮Լڴ
+	virtual size_t ApproximateMemoryUsage() { return 0; };
+
+	//ӵһ>=kentryʼ˳callbackֱcallbackfalseûиentry
+	//ĬGetIteratorʵ֣hashrepֻkڵͰ
+	virtual void Get(const LookupKey& k, void* arg, bool (*callback)(void* arg, const char* entry));
+
+	class Iterator
+	{
+	public:
+		Iterator(){};
+		virtual ~Iterator(){};
+
+		virtual bool Valid() const = 0;
+		virtual const char* key() const = 0;
+		virtual void Next() = 0;
+		virtual void Prev() = 0;
+		//targetΪmemtablekey(varint32 + internal key)
+		virtual void Seek(const char* target) = 0;
+		virtual void SeekToFirst() = 0;
+		virtual void SeekToLast() = 0;
+
+	private:
+		Iterator(const Iterator&);
+		void operator=(const Iterator&);
+	};
+
+	//һKeyComparatorȫĵMemTable::NewIteratorlevel 0д˳
+	virtual Iterator* GetIterator() = 0;
+
+protected:
+	Arena* arena_;
+
+private:
+	MemTableRep(const MemTableRep&);
+	void operator=(const MemTableRep&);
+};
+
+//ͨOptions::memtable_factoryѡmemtableĴ洢ṹ
+class MemTableRepFactory
+{
+public:
+	virtual ~MemTableRepFactory(){};
+
+	virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp, Arena* arena) = 0;
+	virtual const char* Name() const = 0;
+
+	//Ƿ֧allow_concurrent_memtable_write
+	virtual bool IsInsertConcurrentlySupported() const { return false; };
+};
+
+//Ĭϵֲ֧
+extern MemTableRepFactory* NewSkipListRepFactory();
+
+//Options::memtable_factoryΪNULLʱʹõfactoryڹdelete
+extern MemTableRepFactory* DefaultMemTableRepFactory();
+
+//vectorֻ׷ӣдʱŰ׷ӵĲ鲢ʺд̵ĳ
+//дƵʱÿζҪ鲢ӦʹĬϵ
+extern MemTableRepFactory* NewVectorRepFactory(size_t reserved_count = 0);
+
+//user keyǰprefix_lengthֽɢеbucket_countͰÿͰһ
+//ֻҪһͰȫĵҪϲͰ۽ϸ
+extern MemTableRepFactory* NewHashSkipListRepFactory(size_t prefix_length, size_t bucket_count = 50000);
+
+};//leveldb
+
+#endif
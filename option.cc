@@ -15,10 +15,29 @@ Options::Options()
 	, write_buffer_size(4 << 20) //4M
 	, max_open_files(1000)
 	, block_cache(NULL)
+	, block_cache_compressed(NULL)
+	, persistent_cache(NULL)
 	, block_size(4096) //4K
 	, block_restart_interval(16)
 	, compression(kSnappyCompression) //Ĭsnappyѹ
+	, zstd_compression_level(3)
+	, zstd_max_dict_bytes(0)
+	, zstd_max_train_bytes(1 << 20) //1M
+	, parallel_compression_threads(1)
 	, filter_policy(NULL)
+	, cache_index_and_filter_blocks(false)
+	, pin_l0_filter_and_index_blocks_in_cache(false)
+	, partition_index_and_filters(false)
+	, metadata_block_size(4096) //4K
+	, whole_table_filter(false)
+	, max_background_compactions(1)
+	, max_background_flushes(1)
+	, max_subcompactions(1)
+	, allow_concurrent_memtable_write(false)
+	, memtable_factory(NULL)
+	, compaction_readahead_size(2 << 20) //2M
+	, use_direct_io_for_compaction(false)
+	, bytes_per_sync(1 << 20) //1M
 {
 }
 
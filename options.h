@@ -1,6 +1,10 @@
 #ifndef __LEVEL_DB_OPTION_H_
 #define __LEVEL_DB_OPTION_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
 namespace leveldb{
 
 class Cache;
@@ -9,11 +13,15 @@ class Env;
 class Logger;
 class FilterPolicy;
 class Snapshot;
+class MemTableRepFactory;
+class PersistentCache;
 
 enum CompressionType
 {
 	kNoCompression		= 0x00,
-	kSnappyCompression	= 0x01
+	kSnappyCompression	= 0x01,
+	kZstdCompression	= 0x02,
+	kLZ4Compression		= 0x03
 };
 
 struct Options
@@ -37,14 +45,66 @@ struct Options
 	int max_open_files;
 	//cache LRU CACHE
 	Cache* block_cache;
+	//ѹblock cachedata blockļѹԭʼݣλblock_cacheļ֮䡣
+	//ͬڴܶ໺漸ݣblock_cacheûʱֻҪѹҪIONULLʾʹ
+	Cache* block_cache_compressed;
+	//ڱSSDϵĳ־ûblock cache(NewPersistentCache)block_cacheblock_cache_compressedûʱȲ
+	//tableļٵĴ洢ʱʡ󲿷ֶIOȻЧNULLʾʹ
+	PersistentCache* persistent_cache;
 	//С
 	size_t block_size;
 
 	int block_restart_interval;
 	//ѹ
 	CompressionType compression;
+	//ѡѹͣiԪΪi㣬ĲʹһΪʱвʹcompression
+	//ϲýѹLZ4ѹʸߵZSTD
+	std::vector<CompressionType> compression_per_level;
+	//ZSTDѹ
+	int zstd_compression_level;
+	//0ʱʹZSTDѹtableȻzstd_max_train_bytesֽڵkey/value
+	//ɵdata blockѵһzstd_max_dict_bytesֵ䣬tabledata blockֵѹ
+	//ֵΪmeta blocktableСʺvalueСblockظ
+	size_t zstd_max_dict_bytes;
+	size_t zstd_max_train_bytes;
+	//1ʱTableBuilderдdata blockѹ߳ѹ(ͬʱCRC)ٰԭ˳дļ
+	//compaction²ڵ˵ѹٶȡѹ߳ǽڹ̳߳أ߳ȡtableҪֵ
+	//1ʾдtable߳ͬѹ
+	int parallel_compression_threads;
 	//bloom filter
 	const FilterPolicy* filter_policy;
+	//Ϊtrueʱindex blockfilterͨblock_cacheȡʵʴСcache
+	//tableʱڴ沢פκcache
+	bool cache_index_and_filter_blocks;
+	//cache_index_and_filter_blocksʱlevel 0ļindexfilterblock cacheһֱвᱻ̭
+	bool pin_l0_filter_and_index_blocks_in_cache;
+	//Ϊtrueʱindex blockmetadata_block_sizeзֳɶһindex
+	//Ҳindexз֣GetʱֻҪȡkeyڵķ
+	bool partition_index_and_filters;
+	//indexĴС
+	size_t metadata_block_size;
+	//Ϊtrueʱfilter_policytableֻһTableCache::Getڶindex֮ǰͿųtable
+	//NewBlockedBloomFilterPolicyÿֻ̽һcache lineڷ
+	bool whole_table_filter;
+
+	//ͬʱеlevel compactionEnvLOWȼִ̳߳
+	int max_background_compactions;
+	//ͬʱеmemtable flushEnvHIGHȼִ̳߳
+	int max_background_flushes;
+	//һcompactionзֳɶٸkey䲢ִеcompaction1ʾз֡
+	//Сcompactionз֣compactionLOWִ̳߳У̳߳Ϊ˶max_subcompactions - 1߳
+	int max_subcompactions;
+	//ΪtrueʱͬһдĶwritermemtable(skiplistʹCAS)
+	bool allow_concurrent_memtable_write;
+	//memtableĴ洢ṹNULLʾʹĬϵֲ֧repرallow_concurrent_memtable_write
+	MemTableRepFactory* memtable_factory;
+	//compactionȡļʱ̶ԤСӵһblockʼԤ
+	size_t compaction_readahead_size;
+	//compactionļʹdirect IO(Env::NewDirectRandomAccessFile/NewDirectWritableFile)
+	//page cacheǰ̨ȡpageᱻcompactionĴIOȥǰ̨ĶȡȻǻIO
+	bool use_direct_io_for_compaction;
+	//дtableļʱÿдôֽھòϵͳں̨ʼдأSyncһļʱӳẹ̈0ʾر
+	uint64_t bytes_per_sync;
 
 	Options();
 };
@@ -59,7 +119,13 @@ struct ReadOptions
 
 	const Snapshot* snapshot;
 
-	ReadOptions() : verfy_checksums(false), fill_cache(true), snapshot(NULL)
+	//ԤС0ʾӦ⵽ȡdata block8KBʼԤÿη256KB
+	size_t readahead_size;
+
+	//direct IOһtable cache˽tableʱرգcompactionֻɨһεĶȡ
+	bool use_direct_io;
+
+	ReadOptions() : verfy_checksums(false), fill_cache(true), snapshot(NULL), readahead_size(0), use_direct_io(false)
 	{
 	}
 };
@@ -0,0 +1,520 @@
+#include <assert.h>
+#include <stdio.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+#include "persistent_cache.h"
+#include "cache.h"
+#include "env.h"
+#include "coding.h"
+#include "crc32c.h"
+#include "logging.h"
+#include "port.h"
+#include "mutexlock.h"
+
+namespace leveldb{
+
+//ļеļ¼|crc(4ֽ)|key(4ֽ)|data(4ֽ)|key|data|crccrcֽ֮
+static const size_t kRecordHeaderSize = 12;
+//tableblock keyΪ24ֽڣָʱkeyȳֵ˵¼ͷѾ
+static const size_t kMaxKeySize = 256;
+//̭ԶΪλδСȡcapacity1/16[1M, 16M]֮䡣
+//κͻûдĶڴĿεͬʱҲⲿڴ
+static const uint64_t kMinSegmentSize = 1 << 20;
+static const uint64_t kMaxSegmentSize = 16 << 20;
+//ͬʱ򿪵ĶļļֻLookupʱ򿪣LRU cache
+static const int kMaxOpenSegmentFiles = 32;
+
+namespace {
+
+//εڣν¼¼ -> д(full)Ժȴ̨д -> ȫдļԺ(sealed)
+//ͷڴеbuffer֮ļȡ -> ̭(dropped)
+struct Segment
+{
+	uint64_t number;
+	uint64_t size;					//м¼ֽ
+	uint64_t flushed;				//Ѿдļֽ
+	WritableFile* writer;			//֮ǰд
+	std::string buffer;				//֮ǰεȫݣдblock
+	std::vector<std::string> keys;	//еkeyɾʱ
+	bool full;						//ٽµļ¼
+	bool sealed;
+	bool dropped;
+	int refs;						//cacheһą̃дļڼʱټһ
+
+	explicit Segment(uint64_t n) : number(n), size(0), flushed(0), writer(NULL), 
+		full(false), sealed(false), dropped(false), refs(1){};
+
+	~Segment()
+	{
+		if(writer != NULL){
+			writer->Close();
+			delete writer;
+		}
+	}
+};
+
+struct Location
+{
+	Segment* segment;
+	uint64_t offset;
+	size_t size;		//¼ĳ
+
+	Location() : segment(NULL), offset(0), size(0){};
+	Location(Segment* s, uint64_t o, size_t n) : segment(s), offset(o), size(n){};
+};
+
+static std::string SegmentFileName(const std::string& dir, uint64_t number)
+{
+	char buf[100];
+	snprintf(buf, sizeof(buf), "/%06llu.pcache", static_cast<unsigned long long>(number));
+	return dir + buf;
+}
+
+static bool ParseSegmentFileName(const std::string& fname, uint64_t* number)
+{
+	Slice rest(fname);
+	if(!ConsumeDecimalNumber(&rest, number))
+		return false;
+	return rest == Slice(".pcache");
+}
+
+static void EncodeRecord(const Slice& key, const Slice& data, std::string* dst)
+{
+	dst->resize(kRecordHeaderSize);
+	EncodeFixed32(&(*dst)[4], static_cast<uint32_t>(key.size()));
+	EncodeFixed32(&(*dst)[8], static_cast<uint32_t>(data.size()));
+	dst->append(key.data(), key.size());
+	dst->append(data.data(), data.size());
+	EncodeFixed32(&(*dst)[0], crc32c::Mask(crc32c::Value(dst->data() + 4, dst->size() - 4)));
+}
+
+//pʼһ¼ؼ¼ĳȡݲcrcԷ0
+static size_t DecodeRecord(const char* p, size_t n, Slice* key, Slice* data)
+{
+	if(n < kRecordHeaderSize)
+		return 0;
+
+	const uint64_t key_size = DecodeFixed32(p + 4);
+	const uint64_t data_size = DecodeFixed32(p + 8);
+	const uint64_t size = kRecordHeaderSize + key_size + data_size;
+	if(size > n)
+		return 0;
+
+	if(crc32c::Unmask(DecodeFixed32(p)) != crc32c::Value(p + 4, static_cast<size_t>(size) - 4))
+		return 0;
+
+	*key = Slice(p + kRecordHeaderSize, static_cast<size_t>(key_size));
+	*data = Slice(p + kRecordHeaderSize + key_size, static_cast<size_t>(data_size));
+	return static_cast<size_t>(size);
+}
+
+};
+
+//־ṹĳ־ûcacheµblockֻ׷ӵµĻΣ̭ʱɾϵĶļ
+//ֻmu_°Ѽ¼׷ӵεbufferУдļmu_֮Уû߳дʱ
+//̰߳жлûдĲһд꣬дڼ̲߳ļ¼һһд롣
+//ȡmu_ҵλãĶͨfiles_ļȡ
+class LogStructuredPersistentCache : public PersistentCache
+{
+public:
+	LogStructuredPersistentCache(Env* env, const std::string& dir, uint64_t capacity);
+	virtual ~LogStructuredPersistentCache();
+
+	//ɨdirеĶļؽ
+	Status Recover();
+
+	virtual Status Insert(const Slice& key, const Slice& data);
+	virtual Status Lookup(const Slice& key, std::string* data);
+	virtual uint64_t TotalSize();
+
+private:
+	void RecoverSegment(uint64_t number);
+	Status FindFile(uint64_t number, Cache::Handle** handle);
+	Status NewSegment() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+	void WritePending() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+	void SealSegment(Segment* seg) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+	void DropSegment(Segment* seg) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+	void EvictIfNeeded() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+	void Unref(Segment* seg) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+private:
+	Env* const env_;
+	const std::string dir_;
+	const uint64_t capacity_;
+	const uint64_t segment_size_;
+	//α -> RandomAccessFileļɾԺŲʹ
+	Cache* files_;
+
+	port::Mutex mu_;
+	port::CondVar write_cv_;
+	std::map<std::string, Location> index_;
+	std::deque<Segment*> segments_;		//Ŵϵ
+	Segment* active_;					//¼¼ĶΣûʱΪNULL
+	bool writing_;						//Ƿ߳mu_֮дļ
+	uint64_t total_size_;
+	uint64_t next_number_;
+};
+
+static void DeleteSegmentFile(const Slice& key, void* value)
+{
+	delete reinterpret_cast<RandomAccessFile*>(value);
+}
+
+LogStructuredPersistentCache::LogStructuredPersistentCache(Env* env, const std::string& dir, uint64_t capacity)
+	: env_(env), dir_(dir), capacity_(capacity),
+	segment_size_(std::min(std::max(capacity / 16, kMinSegmentSize), kMaxSegmentSize)),
+	files_(NewLRUCache(kMaxOpenSegmentFiles, 0)), write_cv_(&mu_),
+	active_(NULL), writing_(false), total_size_(0), next_number_(1)
+{
+}
+
+LogStructuredPersistentCache::~LogStructuredPersistentCache()
+{
+	{
+		MutexLock l(&mu_);
+		while(writing_)
+			write_cv_.Wait();
+		//ѻڴеļ¼дļ´δʱ
+		if(active_ != NULL)
+			active_->full = true;
+		WritePending();
+
+		for(size_t i = 0; i < segments_.size(); i ++)
+			Unref(segments_[i]);
+		segments_.clear();
+	}
+
+	delete files_;
+}
+
+Status LogStructuredPersistentCache::Recover()
+{
+	//Ŀ¼ѾڣԴ
+	env_->CreateDir(dir_);
+
+	std::vector<std::string> children;
+	Status s = env_->GetChildren(dir_, &children);
+	if(!s.ok())
+		return s;
+
+	std::vector<uint64_t> numbers;
+	for(size_t i = 0; i < children.size(); i ++){
+		uint64_t number;
+		if(ParseSegmentFileName(children[i], &number))
+			numbers.push_back(number);
+	}
+	std::sort(numbers.begin(), numbers.end());
+
+	for(size_t i = 0; i < numbers.size(); i ++)
+		RecoverSegment(numbers[i]);
+	if(!numbers.empty())
+		next_number_ = numbers.back() + 1;
+
+	//ϴ˳ʱĻҲΪֻΣµblockдµĶ
+	MutexLock l(&mu_);
+	EvictIfNeeded();
+	return Status::OK();
+}
+
+//ֻȡÿ¼ͷkeyؽdatacrcLookupʱУ顣
+//¼ļβ(˳ʱдһ)߼¼ͷʱݲʹ
+void LogStructuredPersistentCache::RecoverSegment(uint64_t number)
+{
+	const std::string fname = SegmentFileName(dir_, number);
+	uint64_t file_size = 0;
+	RandomAccessFile* file = NULL;
+	Status s = env_->GetFileSize(fname, &file_size);
+	if(s.ok())
+		s = env_->NewRandomAccessFile(fname, &file);
+
+	Segment* seg = new Segment(number);
+	seg->size = file_size;
+	seg->flushed = file_size;
+	seg->full = true;
+	seg->sealed = true;
+
+	uint64_t pos = 0;
+	char header[kRecordHeaderSize];
+	std::string key_buffer;
+	while(s.ok() && pos + kRecordHeaderSize <= file_size){
+		Slice h;
+		s = file->Read(pos, kRecordHeaderSize, &h, header);
+		if(!s.ok() || h.size() != kRecordHeaderSize)
+			break;
+
+		const uint64_t key_size = DecodeFixed32(h.data() + 4);
+		const uint64_t data_size = DecodeFixed32(h.data() + 8);
+		const uint64_t size = kRecordHeaderSize + key_size + data_size;
+		if(key_size == 0 || key_size > kMaxKeySize || pos + size > file_size)
+			break;
+
+		Slice key;
+		key_buffer.resize(static_cast<size_t>(key_size));
+		s = file->Read(pos + kRecordHeaderSize, static_cast<size_t>(key_size), &key, &key_buffer[0]);
+		if(!s.ok() || key.size() != key_size)
+			break;
+
+		std::string k = key.ToString();
+		if(index_.find(k) == index_.end()){
+			index_[k] = Location(seg, pos, static_cast<size_t>(size));
+			seg->keys.push_back(k);
+		}
+		pos += size;
+	}
+	delete file;
+
+	if(seg->keys.empty()){
+		delete seg;
+		env_->DeleteFile(fname);
+		return;
+	}
+
+	segments_.push_back(seg);
+	total_size_ += seg->size;
+}
+
+Status LogStructuredPersistentCache::FindFile(uint64_t number, Cache::Handle** handle)
+{
+	char buf[sizeof(number)];
+	EncodeFixed64(buf, number);
+	Slice key(buf, sizeof(buf));
+
+	*handle = files_->Lookup(key);
+	if(*handle != NULL)
+		return Status::OK();
+
+	RandomAccessFile* file = NULL;
+	Status s = env_->NewRandomAccessFile(SegmentFileName(dir_, number), &file);
+	if(!s.ok())
+		return s;
+
+	*handle = files_->Insert(key, file, 1, &DeleteSegmentFile);
+	return s;
+}
+
+Status LogStructuredPersistentCache::Insert(const Slice& key, const Slice& data)
+{
+	std::string record;
+	EncodeRecord(key, data, &record);
+	if(record.size() > segment_size_)
+		return Status::InvalidArgument("block is too large for persistent cache");
+
+	MutexLock l(&mu_);
+	const std::string k = key.ToString();
+	if(index_.find(k) != index_.end())
+		return Status::OK();
+
+	if(active_ == NULL || active_->size + record.size() > segment_size_){
+		Status s = NewSegment();
+		if(!s.ok())
+			return s;
+	}
+
+	Segment* seg = active_;
+	index_[k] = Location(seg, seg->size, record.size());
+	seg->keys.push_back(k);
+	seg->buffer.append(record);
+	seg->size += record.size();
+	total_size_ += record.size();
+	EvictIfNeeded();
+
+	//Ѿ߳дʱд¼
+	if(!writing_)
+		WritePending();
+	return Status::OK();
+}
+
+Status LogStructuredPersistentCache::Lookup(const Slice& key, std::string* data)
+{
+	const std::string k = key.ToString();
+	std::string record;
+	Location loc;
+	bool from_file = false;
+	uint64_t number = 0;
+	{
+		MutexLock l(&mu_);
+		std::map<std::string, Location>::iterator it = index_.find(k);
+		if(it == index_.end())
+			return Status::NotFound(Slice());
+
+		loc = it->second;
+		if(!loc.segment->sealed) //ûзĶֱӴڴп
+			record.assign(loc.segment->buffer.data() + loc.offset, loc.size);
+		else{
+			from_file = true;
+			number = loc.segment->number;
+		}
+	}
+
+	//ȡڼοܱ̭ļѾɾʱʧܣû
+	if(from_file){
+		Cache::Handle* handle = NULL;
+		Status s = FindFile(number, &handle);
+		if(!s.ok())
+			return s;
+
+		RandomAccessFile* file = reinterpret_cast<RandomAccessFile*>(files_->Value(handle));
+		record.resize(loc.size);
+		Slice result;
+		s = file->Read(loc.offset, loc.size, &result, &record[0]);
+		//mmapȡʱresultָӳڴ棬ͷhandleԺļܱرգҪȿ
+		if(s.ok() && result.data() != record.data())
+			record.assign(result.data(), result.size());
+		files_->Release(handle);
+		if(!s.ok())
+			return s;
+	}
+
+	Slice rk, rd;
+	if(DecodeRecord(record.data(), record.size(), &rk, &rd) != record.size() || rk != key){
+		//ָʱûУcrc𻵵ļ¼ڵһζʱȥ
+		MutexLock l(&mu_);
+		std::map<std::string, Location>::iterator it = index_.find(k);
+		if(it != index_.end() && it->second.segment == loc.segment && it->second.offset == loc.offset)
+			index_.erase(it);
+		return Status::Corruption("bad persistent cache record");
+	}
+
+	data->assign(rd.data(), rd.size());
+	return Status::OK();
+}
+
+uint64_t LogStructuredPersistentCache::TotalSize()
+{
+	MutexLock l(&mu_);
+	return total_size_;
+}
+
+//һµĶļΪΣԭĻдԺWritePending
+Status LogStructuredPersistentCache::NewSegment()
+{
+	if(active_ != NULL){
+		active_->full = true;
+		active_ = NULL;
+	}
+
+	const uint64_t number = next_number_ ++;
+	WritableFile* writer = NULL;
+	Status s = env_->NewWritableFile(SegmentFileName(dir_, number), &writer);
+	if(!s.ok())
+		return s;
+
+	active_ = new Segment(number);
+	active_->writer = writer;
+	segments_.push_back(active_);
+	return s;
+}
+
+//жлûдļĲд꣬дļʱͷmu_
+//дѾȫдĶη棻дʧܵĶļ¼ֻǲٻ
+void LogStructuredPersistentCache::WritePending()
+{
+	assert(!writing_);
+	writing_ = true;
+
+	while(true){
+		Segment* seg = NULL;
+		for(size_t i = 0; i < segments_.size(); i ++){
+			Segment* s = segments_[i];
+			if(s->sealed)
+				continue;
+			if(s->flushed < s->size){
+				seg = s;
+				break;
+			}
+			if(s->full)
+				SealSegment(s);
+		}
+		if(seg == NULL)
+			break;
+
+		//bufferдڼΪ׷Ӷ·䣬һ
+		std::string batch(seg->buffer, static_cast<size_t>(seg->flushed), static_cast<size_t>(seg->size - seg->flushed));
+		seg->refs ++;
+
+		mu_.Unlock();
+		Status s = seg->writer->Append(batch);
+		if(s.ok())
+			s = seg->writer->Flush();
+		mu_.Lock();
+
+		if(!seg->dropped){
+			if(s.ok())
+				seg->flushed += batch.size();
+			else{
+				if(seg == active_)
+					active_ = NULL;
+				DropSegment(seg);
+			}
+		}
+		Unref(seg);
+	}
+
+	writing_ = false;
+	write_cv_.SignalAll();
+}
+
+//ȫдļĶιرдͷڴеbuffer֮ļȡ
+void LogStructuredPersistentCache::SealSegment(Segment* seg)
+{
+	assert(seg->full && seg->flushed == seg->size);
+	seg->writer->Close();
+	delete seg->writer;
+	seg->writer = NULL;
+	std::string().swap(seg->buffer);
+	seg->sealed = true;
+}
+
+//ȥеkeyɾļдε̳߳ãдͷţ
+//ڶLookupͨfiles_д򿪵ļ
+void LogStructuredPersistentCache::DropSegment(Segment* seg)
+{
+	for(size_t i = 0; i < seg->keys.size(); i ++){
+		std::map<std::string, Location>::iterator it = index_.find(seg->keys[i]);
+		if(it != index_.end() && it->second.segment == seg)
+			index_.erase(it);
+	}
+
+	char buf[sizeof(seg->number)];
+	EncodeFixed64(buf, seg->number);
+	files_->Erase(Slice(buf, sizeof(buf)));
+
+	segments_.erase(std::find(segments_.begin(), segments_.end(), seg));
+	total_size_ -= seg->size;
+	seg->dropped = true;
+	env_->DeleteFile(SegmentFileName(dir_, seg->number));
+	Unref(seg);
+}
+
+//βᱻ̭
+void LogStructuredPersistentCache::EvictIfNeeded()
+{
+	while(total_size_ > capacity_ && !segments_.empty() && segments_.front() != active_)
+		DropSegment(segments_.front());
+}
+
+void LogStructuredPersistentCache::Unref(Segment* seg)
+{
+	assert(seg->refs > 0);
+	seg->refs --;
+	if(seg->refs == 0)
+		delete seg;
+}
+
+Status NewPersistentCache(Env* env, const std::string& dir, uint64_t capacity, PersistentCache** result)
+{
+	*result = NULL;
+	LogStructuredPersistentCache* cache = new LogStructuredPersistentCache(env, dir, capacity);
+	Status s = cache->Recover();
+	if(!s.ok()){
+		delete cache;
+		return s;
+	}
+
+	*result = cache;
+	return s;
+}
+
+};//leveldb
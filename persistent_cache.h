@@ -0,0 +1,41 @@
+#ifndef __LEVEL_DB_PERSISTENT_CACHE_H_
+#define __LEVEL_DB_PERSISTENT_CACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include "slice.h"
+#include "status.h"
+
+namespace leveldb{
+
+class Env;
+
+//ڱSSDϵblock cacheλblock_cacheblock_cache_compressedtableļ֮䡣
+//data blockļеԭʼ( + 1ֽѹ)keytableļšļСblockƫɣ
+//ڵcache idȻЧ
+class PersistentCache
+{
+public:
+	PersistentCache(){};
+	virtual ~PersistentCache(){};
+
+	//keyѾʱʲôҲдʧֻٻһblock߿ԺԷֵ
+	virtual Status Insert(const Slice& key, const Slice& data) = 0;
+	//ûҵNotFoundcacheļеļ¼𻵷Corruption
+	virtual Status Lookup(const Slice& key, std::string* data) = 0;
+	//cacheļǰռõֽ
+	virtual uint64_t TotalSize() = 0;
+
+private:
+	PersistentCache(const PersistentCache&);
+	void operator=(const PersistentCache&);
+};
+
+//Ŀ¼dir´־ṹĳ־ûcacheblock˳׷ӵļУڴֻkeyļλõ
+//ܴСcapacityʱɾϵĶļʱֻȡļеļ¼ͷؽ¼crcڶȡʱУ顣
+//dirӦֻһDBʹãDBɾؽʱҪһգͬļŵľblockᱻļ
+extern Status NewPersistentCache(Env* env, const std::string& dir, uint64_t capacity, PersistentCache** result);
+
+};//leveldb
+
+#endif
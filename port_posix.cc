@@ -1,8 +1,11 @@
 #include "port_posix.h"
 
+#include <assert.h>
 #include <cstdlib>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "logging.h"
 
 namespace leveldb{
@@ -69,6 +72,211 @@ void InitOnce(OnceType* once, void (*initializer)())
 	PthreadCall("once", pthread_once(once, initializer));
 }
 
+int NumberOfCPUs()
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return cpus > 0 ? static_cast<int>(cpus) : 1;
+}
+
+char* AllocateHugePageBlock(size_t size)
+{
+	void* block = NULL;
+	if(posix_memalign(&block, size, size) != 0)
+		block = malloc(size);
+	assert(block != NULL);
+#ifdef MADV_HUGEPAGE
+	madvise(block, size, MADV_HUGEPAGE);
+#endif
+	return reinterpret_cast<char*>(block);
+}
+
+void FreeHugePageBlock(char* block)
+{
+	free(block);
+}
+
+#ifdef ZSTD
+//ZSTDĴ۱ѹһ4KBblockߣÿ̻߳һ߳˳ʱͷ
+static pthread_key_t zstd_cctx_key;
+static pthread_key_t zstd_dctx_key;
+static pthread_once_t zstd_once = PTHREAD_ONCE_INIT;
+
+static void FreeZstdCCtx(void* arg)
+{
+	ZSTD_freeCCtx(reinterpret_cast<ZSTD_CCtx*>(arg));
+}
+
+static void FreeZstdDCtx(void* arg)
+{
+	ZSTD_freeDCtx(reinterpret_cast<ZSTD_DCtx*>(arg));
+}
+
+static void InitZstdKeys()
+{
+	PthreadCall("zstd key", pthread_key_create(&zstd_cctx_key, FreeZstdCCtx));
+	PthreadCall("zstd key", pthread_key_create(&zstd_dctx_key, FreeZstdDCtx));
+}
+
+static ZSTD_CCtx* ThreadZstdCCtx()
+{
+	pthread_once(&zstd_once, InitZstdKeys);
+	ZSTD_CCtx* ctx = reinterpret_cast<ZSTD_CCtx*>(pthread_getspecific(zstd_cctx_key));
+	if(ctx == NULL && (ctx = ZSTD_createCCtx()) != NULL)
+		pthread_setspecific(zstd_cctx_key, ctx);
+	return ctx;
+}
+
+static ZSTD_DCtx* ThreadZstdDCtx()
+{
+	pthread_once(&zstd_once, InitZstdKeys);
+	ZSTD_DCtx* ctx = reinterpret_cast<ZSTD_DCtx*>(pthread_getspecific(zstd_dctx_key));
+	if(ctx == NULL && (ctx = ZSTD_createDCtx()) != NULL)
+		pthread_setspecific(zstd_dctx_key, ctx);
+	return ctx;
+}
+#endif
+
+bool Zstd_Compress(int level, const char* input, size_t length, ::std::string* output)
+{
+#ifdef ZSTD
+	ZSTD_CCtx* ctx = ThreadZstdCCtx();
+	if(ctx == NULL)
+		return false;
+
+	output->resize(ZSTD_compressBound(length));
+	const size_t outlen = ZSTD_compressCCtx(ctx, &(*output)[0], output->size(), input, length, level);
+	if(ZSTD_isError(outlen))
+		return false;
+	output->resize(outlen);
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Zstd_Uncompress(const char* input, size_t length, char* output, size_t output_length)
+{
+#ifdef ZSTD
+	ZSTD_DCtx* ctx = ThreadZstdDCtx();
+	if(ctx == NULL)
+		return false;
+
+	const size_t r = ZSTD_decompressDCtx(ctx, output, output_length, input, length);
+	return !ZSTD_isError(r) && r == output_length;
+#else
+	return false;
+#endif
+}
+
+bool Zstd_TrainDictionary(const ::std::string& samples, const ::std::vector<size_t>& sample_sizes,
+	size_t max_dict_bytes, ::std::string* dict)
+{
+#ifdef ZSTD
+	if(sample_sizes.empty() || max_dict_bytes == 0)
+		return false;
+
+	dict->resize(max_dict_bytes);
+	const size_t n = ZDICT_trainFromBuffer(&(*dict)[0], max_dict_bytes, samples.data(),
+		&sample_sizes[0], static_cast<unsigned>(sample_sizes.size()));
+	if(ZDICT_isError(n)){ //̫ʱѵʧ
+		dict->clear();
+		return false;
+	}
+	dict->resize(n);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void* Zstd_NewCompressDict(const char* dict, size_t length, int level)
+{
+#ifdef ZSTD
+	return ZSTD_createCDict(dict, length, level);
+#else
+	return NULL;
+#endif
+}
+
+void Zstd_DeleteCompressDict(void* cdict)
+{
+#ifdef ZSTD
+	ZSTD_freeCDict(reinterpret_cast<ZSTD_CDict*>(cdict));
+#endif
+}
+
+void* Zstd_NewUncompressDict(const char* dict, size_t length)
+{
+#ifdef ZSTD
+	return ZSTD_createDDict(dict, length);
+#else
+	return NULL;
+#endif
+}
+
+void Zstd_DeleteUncompressDict(void* ddict)
+{
+#ifdef ZSTD
+	ZSTD_freeDDict(reinterpret_cast<ZSTD_DDict*>(ddict));
+#endif
+}
+
+bool Zstd_CompressWithDict(void* cdict, const char* input, size_t length, ::std::string* output)
+{
+#ifdef ZSTD
+	ZSTD_CCtx* ctx = ThreadZstdCCtx();
+	if(ctx == NULL)
+		return false;
+
+	output->resize(ZSTD_compressBound(length));
+	const size_t outlen = ZSTD_compress_usingCDict(ctx, &(*output)[0], output->size(), input, length,
+		reinterpret_cast<const ZSTD_CDict*>(cdict));
+	if(ZSTD_isError(outlen))
+		return false;
+	output->resize(outlen);
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Zstd_UncompressWithDict(void* ddict, const char* input, size_t length, char* output, size_t output_length)
+{
+#ifdef ZSTD
+	if(ddict == NULL || ZSTD_getDictID_fromFrame(input, length) == 0)
+		return Zstd_Uncompress(input, length, output, output_length);
+
+	ZSTD_DCtx* ctx = ThreadZstdDCtx();
+	if(ctx == NULL)
+		return false;
+
+	const size_t r = ZSTD_decompress_usingDDict(ctx, output, output_length, input, length,
+		reinterpret_cast<const ZSTD_DDict*>(ddict));
+	return !ZSTD_isError(r) && r == output_length;
+#else
+	return false;
+#endif
+}
+
+//__builtin_cpu_supportsͬʱCPUIDͲϵͳǷ񱣴YMMĴ(XGETBV)
+bool HasSSE42()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_cpu_supports("sse4.2");
+#else
+	return false;
+#endif
+}
+
+bool HasAVX2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
 }
 }
 
@@ -34,11 +34,22 @@
 #endif
 
 #include <pthread.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
 #ifdef SNAPPY
 #include <snappy.h>
 #endif
+#ifdef LZ4
+#include <lz4.h>
+#endif
+#ifdef ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
 #include <stdint.h>
 #include <string>
+#include <vector>
 #include "atomic_pointer.h"
 
 
@@ -135,6 +146,109 @@ inline bool Snappy_Uncompress(const char* input, size_t length, char* output)
 #endif
 }
 
+//LZ4ѹװLZ4Ŀʽ¼ԭʼȣǰ4ֽ(С)Ϊԭʼ
+inline bool LZ4_Compress(const char* input, size_t length, ::std::string* output)
+{
+#ifdef LZ4
+		if(length > static_cast<size_t>(LZ4_MAX_INPUT_SIZE))
+			return false;
+
+		const int bound = LZ4_compressBound(static_cast<int>(length));
+		output->resize(4 + bound);
+		char* p = &(*output)[0];
+		for(int i = 0; i < 4; i ++)
+			p[i] = static_cast<char>((length >> (8 * i)) & 0xff);
+
+		const int outlen = LZ4_compress_default(input, p + 4, static_cast<int>(length), bound);
+		if(outlen <= 0)
+			return false;
+		output->resize(4 + outlen);
+		return true;
+#else
+		return false;
+#endif
+}
+
+inline bool LZ4_GetUncompressedLength(const char* input, size_t length, size_t* result)
+{
+#ifdef LZ4
+		if(length < 4)
+			return false;
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
+		*result = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8) |
+			(static_cast<size_t>(p[2]) << 16) | (static_cast<size_t>(p[3]) << 24);
+		return true;
+#else
+		return false;
+#endif
+}
+
+inline bool LZ4_Uncompress(const char* input, size_t length, char* output, size_t output_length)
+{
+#ifdef LZ4
+		if(length < 4)
+			return false;
+		const int r = LZ4_decompress_safe(input + 4, output, static_cast<int>(length - 4), static_cast<int>(output_length));
+		return r >= 0 && static_cast<size_t>(r) == output_length;
+#else
+		return false;
+#endif
+}
+
+//ZSTDѹװ֡ͷм¼ԭʼȡѹ/ѹÿ̻߳һ
+extern bool Zstd_Compress(int level, const char* input, size_t length, ::std::string* output);
+
+inline bool Zstd_GetUncompressedLength(const char* input, size_t length, size_t* result)
+{
+#ifdef ZSTD
+		const unsigned long long n = ZSTD_getFrameContentSize(input, length);
+		if(n == ZSTD_CONTENTSIZE_UNKNOWN || n == ZSTD_CONTENTSIZE_ERROR)
+			return false;
+		*result = static_cast<size_t>(n);
+		return true;
+#else
+		return false;
+#endif
+}
+
+extern bool Zstd_Uncompress(const char* input, size_t length, char* output, size_t output_length);
+
+//samplesѵһmax_dict_bytesZSTDֵ䣬samplesΪβӵĶsample_sizesΪÿĳ
+extern bool Zstd_TrainDictionary(const ::std::string& samples, const ::std::vector<size_t>& sample_sizes,
+	size_t max_dict_bytes, ::std::string* dict);
+
+//Ԥȴõֵ(ZSTD_CDict/ZSTD_DDict)ͬһֵѹ/ѹܶСblockʱʡȥÿμֵĿ
+//ʧܻûбZSTDʱNULL
+extern void* Zstd_NewCompressDict(const char* dict, size_t length, int level);
+extern void Zstd_DeleteCompressDict(void* cdict);
+extern void* Zstd_NewUncompressDict(const char* dict, size_t length);
+extern void Zstd_DeleteUncompressDict(void* ddict);
+
+extern bool Zstd_CompressWithDict(void* cdict, const char* input, size_t length, ::std::string* output);
+//ûʹֵѹ֡(֡ͷdict idΪ0)ͨ֡ѹ
+extern bool Zstd_UncompressWithDict(void* ddict, const char* input, size_t length, char* output, size_t output_length);
+
+//ʱCPUǷֶ֧ӦָͨõĶѡSIMDʵ
+extern bool HasSSE42();
+extern bool HasAVX2();
+
+//ߵCPU޷ȡʱ1
+extern int NumberOfCPUs();
+
+//sizeСsizeڴ飬ʾںʹ͸ҳFreeHugePageBlockͷ
+extern char* AllocateHugePageBlock(size_t size);
+extern void FreeHugePageBlock(char* block);
+
+//ǰ߳ڵCPU˱ţ֧ʱ-1
+inline int PhysicalCoreID()
+{
+#if defined(__linux__) && defined(__GLIBC__)
+	return sched_getcpu();
+#else
+	return -1;
+#endif
+}
+
 inline bool GetHeapProfile(void (*func)(void*, const char*, int), void* arg) 
 {
 	return false;
@@ -7,6 +7,12 @@
 #include "arena.h"
 #include "random.h"
 
+#if defined(_MSC_VER)
+#define LEVELDB_THREAD_LOCAL __declspec(thread)
+#else
+#define LEVELDB_THREAD_LOCAL __thread
+#endif
+
 namespace leveldb{
 
 class Arena;
@@ -19,9 +25,12 @@ private:
 	struct Node;
 
 public:
-	explicit SkipList(Comparator cmp, Arena* arena);
+	//concurrentΪtrueʱͷڵAllocateAlignedConcurrent䣬ڿ̵ܺ߳ĲͬʱеĹ
+	explicit SkipList(Comparator cmp, Arena* arena, bool concurrent = false);
 	void Insert(const Key& key);
-	void Contains(const Key& key) const;
+	//߳̿ͬʱõĲ룬ͨCASÿһnextָ룬ԺͶ
+	void InsertConcurrently(const Key& key);
+	bool Contains(const Key& key) const;
 
 	class Iterator
 	{
@@ -59,7 +68,10 @@ private:
 
 private:
 	Node* NewNode(const key& key, int height);
+	Node* NewNodeConcurrently(const Key& key, int height);
 	int RandomHeigth();
+	int RandomHeightConcurrently();
+	void FindSpliceForLevel(const Key& key, Node* before, int level, Node** out_prev, Node** out_next) const;
 	bool Equal(const Key& a, const Key& b) const 
 	{
 		return (compare_(a,b) == 0);
@@ -102,6 +114,13 @@ struct SkipList<Key, Comparator>::Node
 		 next_[n].NoBarrier_Store(x);
 	}
 
+	//next_[n]Ȼexpectedʱ滻x
+	bool CASNext(int n, Node* expected, Node* x)
+	{
+		assert(n >= 0);
+		return next_[n].CompareAndSwap(expected, x);
+	}
+
 private:
 	port::AtomicPointer next_[1];
 };
@@ -115,6 +134,14 @@ typedef SkipList<Key, Comparator>::Node*
 	return new (mem) Node(key);
 }
 
+template<typename Key, class Comparator>
+typename SkipList<Key, Comparator>::Node*
+	SkipList<Key, Comparator>::NewNodeConcurrently(const Key& key, int height)
+{
+	char* mem = arena_->AllocateAlignedConcurrent(sizeof(Node) + sizeof(port::AtomicPointer) * (height - 1));
+	return new (mem) Node(key);
+}
+
 template<typename Key, class Comparator>
 inline SkipList<Key, Comparator>::Iterator::Iterator(const SkipList* list)
 {
@@ -185,6 +212,31 @@ int SkipList<Key, Comparator>::RandomHeigth()
 	return height;
 }
 
+//rnd_ֻܱһд߳ʹãʱÿ߳ʹԼ
+template<typename Key, class Comparator>
+int SkipList<Key, Comparator>::RandomHeightConcurrently()
+{
+	static LEVELDB_THREAD_LOCAL uint32_t seed = 0;
+	if(seed == 0) //߳ջַʼ
+		seed = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&seed) >> 4) | 1;
+
+	static const unsigned int kBranching = 4;
+	int height = 1;
+	while(height < kMaxHeight){
+		//xorshift32
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		if(seed % kBranching != 0)
+			break;
+		height ++;
+	}
+
+	assert(height > 0);
+	assert(height <= kMaxHeight);
+	return height;
+}
+
 //жkeyǷnodeĺ棬Ϊskiplist(n.key < key)
 template<typename Key, class Comparator>
 bool SkipList<Key, Comparator>::KeyIsAfterNode(const Key& key, Node* n) const
@@ -215,6 +267,23 @@ typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindGreater
 	}
 }
 
+//beforeʼlevelҵkeyĲλãout_prev->key < key <= out_next->key
+template<typename Key, class Comparator>
+void SkipList<Key, Comparator>::FindSpliceForLevel(const Key& key, Node* before, int level, 
+												   Node** out_prev, Node** out_next) const
+{
+	while(true){
+		Node* next = before->Next(level);
+		if(KeyIsAfterNode(key, next))
+			before = next;
+		else{
+			*out_prev = before;
+			*out_next = next;
+			return;
+		}
+	}
+}
+
 template<typename Key, class Comparator>
 typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast() const
 {
@@ -234,8 +303,8 @@ typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast()
 } 
 
 template<typename Key, class Comparator>
-SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena)
-	: compare_(cmp), arena_(arena), head_(NewNode(0, kMaxHeight)),
+SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena, bool concurrent)
+	: compare_(cmp), arena_(arena), head_(concurrent ? NewNodeConcurrently(0, kMaxHeight) : NewNode(0, kMaxHeight)),
 	max_height_(reinterpret_cast<void*>(1)), rnd_(0xdeadbeef)
 {
 	for(int i = 0; i < kMaxHeight; i++)
@@ -267,6 +336,45 @@ void SkipList<Key, Comparator>::Insert(const Key& key)
 	}
 }
 
+template<typename Key, class Comparator>
+void SkipList<Key, Comparator>::InsertConcurrently(const Key& key)
+{
+	int height = RandomHeightConcurrently();
+
+	//CAS߶ȣʧ˵߳Ѿ޸ˣ¶ȡ
+	int max_height = GetMaxHeight();
+	while(height > max_height){
+		if(max_height_.CompareAndSwap(reinterpret_cast<void*>(max_height), reinterpret_cast<void*>(height))){
+			max_height = height;
+			break;
+		}
+		max_height = GetMaxHeight();
+	}
+
+	//Զ¼ÿһĲλ
+	Node* prev[kMaxHeight];
+	Node* next[kMaxHeight];
+	Node* before = head_;
+	for(int i = max_height - 1; i >= 0; i --){
+		FindSpliceForLevel(key, before, i, &prev[i], &next[i]);
+		before = prev[i];
+	}
+
+	Node* x = NewNodeConcurrently(key, height);
+	//Եӣ֤ڵڸ߲ɼʱײһѾӺ
+	for(int i = 0; i < height; i ++){
+		while(true){
+			assert(next[i] == NULL || compare_(key, next[i]->key) < 0);
+			x->NoBarrier_SetNext(i, next[i]);
+			if(prev[i]->CASNext(i, next[i], x))
+				break;
+
+			//prev[i]µĽڵ㣬prev[i]ʼ²һλ
+			FindSpliceForLevel(key, prev[i], i, &prev[i], &next[i]);
+		}
+	}
+}
+
 template<typename Key, class Comparator>
 bool SkipList<Key, Comparator>::Contains(const Key& key) const
 {
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "table.h"
 #include "cache.h"
 #include "comparator.h"
@@ -5,9 +6,12 @@
 #include "filter_policy.h"
 #include "options.h"
 #include "filter_block.h"
+#include "block.h"
 #include "format.h"
+#include "persistent_cache.h"
 #include "two_level_iterator.h"
 #include "coding.h"
+#include "port.h"
 
 namespace leveldb{
 
@@ -18,6 +22,11 @@ struct Table::Rep
 	
 	RandomAccessFile* file;	//ļ
 	uint64_t cache_id;		//cache id
+	uint64_t compressed_cache_id;	//ѹblock cacheеcache id
+	//options.persistent_cache֪ļʱΪNULLkeyΪļ + ļС + blockƫ
+	PersistentCache* persistent_cache;
+	uint64_t file_number;
+	uint64_t file_size;
 
 	FilterBlockReader* filter; //
 	const char* filter_data;	
@@ -25,16 +34,83 @@ struct Table::Rep
 	BlockHandle metaindex_handle;
 	Block* index_block;
 
+	//cache_index_and_filter_blocksʱindexfilterͨblock cacheȡ
+	//index_blockfilterΪNULLhandleblock cacheв
+	bool cache_index_and_filter;
+	BlockHandle index_handle;
+	bool has_filter;
+	BlockHandle filter_handle;
+	//pinסindex/filterblock cacheеhandletableرʱͷ
+	Cache::Handle* pinned_index;
+	Cache::Handle* pinned_filter;
+
+	//index_blockǶindexvalueΪindexhandleʱٸhandle
+	bool partitioned_index;
+	bool partitioned_filter;
+
+	//data blockʹõZSTDֵ䣬tableûֵʱΪNULL
+	void* zstd_dict;
+
 	~Rep()
 	{
-		delete filter;
-		delete []filter_data;
-		delete index_block;
+		if(zstd_dict != NULL)
+			port::Zstd_DeleteUncompressDict(zstd_dict);
+
+		if(pinned_filter != NULL)
+			options.block_cache->Release(pinned_filter);
+		else{
+			delete filter;
+			delete []filter_data;
+		}
+
+		if(pinned_index != NULL)
+			options.block_cache->Release(pinned_index);
+		else
+			delete index_block;
 	}
 };
 
+//block cacheеĹ
+struct CachedFilter
+{
+	FilterBlockReader* reader;
+	const char* data; //heapϷfilterݣmmapʱΪNULL
+};
+
+static void DeleteCachedFilter(const Slice& key, void* value)
+{
+	CachedFilter* f = reinterpret_cast<CachedFilter*>(value);
+	delete f->reader;
+	delete []f->data;
+	delete f;
+}
+
+//block cacheеĹ
+struct CachedFullFilter
+{
+	FullFilterBlockReader* reader;
+	const char* data;
+};
+
+static void DeleteCachedFullFilter(const Slice& key, void* value)
+{
+	CachedFullFilter* f = reinterpret_cast<CachedFullFilter*>(value);
+	delete f->reader;
+	delete []f->data;
+	delete f;
+}
+
+//id + offset = cache key
+static Slice BlockCacheKey(uint64_t cache_id, const BlockHandle& handle, char* buf)
+{
+	EncodeFixed64(buf, cache_id);
+	EncodeFixed64(buf + 8, handle.offset());
+	return Slice(buf, 16);
+}
+
 //Ӧtable builderеFinish
-Status Table::Open(const Options& options, RandomAccessFile* file, uint64_t size, Table** table)
+Status Table::Open(const Options& options, RandomAccessFile* file, uint64_t size, Table** table, bool pin_index_and_filter,
+	uint64_t file_number)
 {
 	*table = NULL;
 	if(size < Footer::kEncodedLength)
@@ -47,18 +123,28 @@ Status Table::Open(const Options& options, RandomAccessFile* file, uint64_t size
 	if(!s.ok())
 		return s;
 
+	//ûпfooter_space˵mmapļļδѹblockֱָӳڴ(cachableΪfalse)
+	//tableرԺʧЧܷŽblock cache
+	const bool mmapped = (footer_input.data() != footer_space);
+
 	//footerĽ
 	Footer footer;
 	s = footer.DecodeFrom(&footer_input);
 	if(!s.ok())
 		return s;
 
+	//index blockfilterͨblock cacheȡʱtableʱȡindex block
+	//mmapļڴʱindexfilterrep_
+	const bool cache_index_and_filter = options.cache_index_and_filter_blocks && options.block_cache != NULL && !mmapped;
+
 	//index blockĶȡ
 	BlockContents contents;
 	Block* index_block = NULL;
-	s = ReadBlock(file, ReadOptions(), footer.index_handle(), &contents);
-	if(s.ok()){
-		index_block = new Block(contents);
+	if(!cache_index_and_filter){
+		s = ReadBlock(file, ReadOptions(), footer.index_handle(), &contents);
+		if(s.ok()){
+			index_block = new Block(contents);
+		}
 	}
 
 	if(s.ok()){
@@ -68,11 +154,37 @@ Status Table::Open(const Options& options, RandomAccessFile* file, uint64_t size
 		r->metaindex_handle = footer.metaindex_handle();
 		r->index_block = index_block;
 		r->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
+		r->compressed_cache_id = (options.block_cache_compressed ? options.block_cache_compressed->NewId() : 0);
+		r->persistent_cache = (file_number != 0 ? options.persistent_cache : NULL);
+		r->file_number = file_number;
+		r->file_size = size;
 		r->filter_data = NULL;
 		r->filter = NULL;
+		r->cache_index_and_filter = cache_index_and_filter;
+		r->index_handle = footer.index_handle();
+		r->has_filter = false;
+		r->pinned_index = NULL;
+		r->pinned_filter = NULL;
+		r->partitioned_index = false;
+		r->partitioned_filter = false;
+		r->zstd_dict = NULL;
 		*table = new Table(r);
+
+		//pinסindex blockblock cacheһֱhandleڴblock cacheᱻ̭
+		if(cache_index_and_filter && pin_index_and_filter){
+			s = (*table)->GetIndexBlock(&r->index_block, &r->pinned_index);
+			if(!s.ok()){
+				delete *table;
+				*table = NULL;
+				return s;
+			}
+		}
+
 		//ȡmeta index block
 		(*table)->ReadMeta(footer);
+
+		if(cache_index_and_filter && pin_index_and_filter && r->has_filter)
+			r->filter = (*table)->GetFilter(&r->pinned_filter);
 	}
 	else if(index_block != NULL){
 		delete index_block;
@@ -84,9 +196,6 @@ Status Table::Open(const Options& options, RandomAccessFile* file, uint64_t size
 //meta index blockĶȡ
 void Table::ReadMeta(const Footer& footer)
 {
-	if(rep_->options.filter_policy == NULL)
-		return;
-
 	//ȡmeta index block
 	ReadOptions opt;
 	BlockContents contents;
@@ -96,19 +205,57 @@ void Table::ReadMeta(const Footer& footer)
 
 	Block* meta = new Block(contents);
 
-	//ԹϢĶȡ
 	Iterator* iter = meta->NewIterator(BytewiseComparator());
-	std::string key = "filter.";
-	key.append(rep_->options.filter_policy->name());
-	iter->Seek(key);
-	if(iter->Valid() && iter->key() == Slice(key)){
-		ReadFilter(iter->value()); //ԹձĶȡ
+	//ǷǷindex
+	iter->Seek("index.partitioned");
+	rep_->partitioned_index = (iter->Valid() && iter->key() == Slice("index.partitioned"));
+
+	//ֵֻڴʱһΣZSTD_DDictפڴ
+	iter->Seek(kCompressionDictBlockName);
+	if(iter->Valid() && iter->key() == Slice(kCompressionDictBlockName))
+		ReadCompressionDict(iter->value());
+
+	//ԹϢĶȡ
+	if(rep_->options.filter_policy != NULL){
+		std::string key = "filter.";
+		key.append(rep_->options.filter_policy->name());
+		iter->Seek(key);
+		if(iter->Valid() && iter->key() == Slice(key)){
+			ReadFilter(iter->value()); //ԹձĶȡ
+		}
+
+		//λڶindexУֻҪȷϹһ
+		if(rep_->partitioned_index){
+			key = "partitionedfilter.";
+			key.append(rep_->options.filter_policy->name());
+			iter->Seek(key);
+			rep_->partitioned_filter = (iter->Valid() && iter->key() == Slice(key));
+		}
 	}
 
 	delete iter;
 	delete meta;
 }
 
+void Table::ReadCompressionDict(const Slice& dict_handle_value)
+{
+	Slice v = dict_handle_value;
+	BlockHandle dict_handle;
+	if(!dict_handle.DecodeFrom(&v).ok())
+		return;
+
+	ReadOptions opt;
+	opt.verfy_checksums = true;
+	BlockContents block;
+	if(!ReadBlock(rep_->file, opt, dict_handle, &block).ok())
+		return;
+
+	//ZSTD_DDictֵ
+	rep_->zstd_dict = port::Zstd_NewUncompressDict(block.data.data(), block.data.size());
+	if(block.heap_allocated)
+		delete []block.data.data();
+}
+
 void Table::ReadFilter(const Slice& filter_handle_value)
 {
 	Slice v = filter_handle_value;
@@ -117,6 +264,13 @@ void Table::ReadFilter(const Slice& filter_handle_value)
 		return ;
 	}
 
+	//ͨblock cacheȡʱֻ¼filterλãõʱٶ
+	if(rep_->cache_index_and_filter){
+		rep_->has_filter = true;
+		rep_->filter_handle = filter_handle;
+		return ;
+	}
+
 	ReadOptions opt;
 	BlockContents block;
 	if(!ReadBlock(rep_->file, opt, filter_handle, &block).ok()){
@@ -136,6 +290,7 @@ Table::~Table()
 	delete rep_;
 }
 
+
 static void DeleteBlock(void* arg, void * ignored)
 {
 	delete reinterpret_cast<Block*>(arg);
@@ -147,6 +302,11 @@ static void DeleteCachedBlock(const Slice& key, void* value)
 	delete block;
 }
 
+static void DeleteCachedCompressedBlock(const Slice& key, void* value)
+{
+	delete reinterpret_cast<std::string*>(value);
+}
+
 static void ReleaseBlock(void* arg, void* h)
 {
 	Cache* cache = reinterpret_cast<Cache*>(arg);
@@ -154,103 +314,630 @@ static void ReleaseBlock(void* arg, void* h)
 	cache->Release(handle);
 }
 
-//ȡһ飬
-Iterator* Table::BlockReader(void* arg, const ReadOptions& opt, const Slice& index_value)
+//index blockפڴʱֱӷأblock cacheвңcacheоʹļȡ롣
+//*cache_handleΪNULLʱҪRelease
+Status Table::GetIndexBlock(Block** block, Cache::Handle** cache_handle) const
 {
-	Table* table = reinterpret_cast<Table*>(arg);
-	Cache* block_cache = table->rep_->options.block_cache;
+	*cache_handle = NULL;
+	if(rep_->index_block != NULL){
+		*block = rep_->index_block;
+		return Status::OK();
+	}
+
+	Cache* block_cache = rep_->options.block_cache;
+	char cache_key_buffer[16];
+	Slice key = BlockCacheKey(rep_->cache_id, rep_->index_handle, cache_key_buffer);
+	*cache_handle = block_cache->Lookup(key);
+	if(*cache_handle != NULL){
+		*block = reinterpret_cast<Block*>(block_cache->Value(*cache_handle));
+		return Status::OK();
+	}
+
+	BlockContents contents;
+	Status s = ReadBlock(rep_->file, ReadOptions(), rep_->index_handle, &contents);
+	if(!s.ok())
+		return s;
+
+	//ֻpreadʽļߵ(Openжmmapж)blockheapϣԽblock cacheͷ
+	assert(contents.cachable && contents.heap_allocated);
+
+	//blockʵʴСcacheԸȼ룬ױscan
+	*block = new Block(contents);
+	*cache_handle = block_cache->Insert(key, *block, (*block)->size(), &DeleteCachedBlock, Cache::HIGH);
+	return s;
+}
+
+//ùûй߶ȡʧܷNULL*cache_handleĴͬGetIndexBlock
+FilterBlockReader* Table::GetFilter(Cache::Handle** cache_handle) const
+{
+	*cache_handle = NULL;
+	if(rep_->filter != NULL || !rep_->has_filter)
+		return rep_->filter;
+
+	Cache* block_cache = rep_->options.block_cache;
+	char cache_key_buffer[16];
+	Slice key = BlockCacheKey(rep_->cache_id, rep_->filter_handle, cache_key_buffer);
+	*cache_handle = block_cache->Lookup(key);
+	if(*cache_handle != NULL)
+		return reinterpret_cast<CachedFilter*>(block_cache->Value(*cache_handle))->reader;
+
+	BlockContents block;
+	if(!ReadBlock(rep_->file, ReadOptions(), rep_->filter_handle, &block).ok())
+		return NULL;
+
+	assert(block.cachable && block.heap_allocated);
+	CachedFilter* f = new CachedFilter;
+	f->data = block.data.data();
+	f->reader = new FilterBlockReader(rep_->options.filter_policy, block.data);
+	*cache_handle = block_cache->Insert(key, f, block.data.size(), &DeleteCachedFilter, Cache::HIGH);
+	return f->reader;
+}
+
+//ȡһ鲢ȴblock cacheв
+Iterator* Table::ReadBlockIterator(const ReadOptions& opt, const BlockHandle& handle, Cache::Priority priority) const
+{
+	Cache* block_cache = rep_->options.block_cache;
 	Block* block = NULL;
 	Cache::Handle* cache_handle = NULL;
-	//λ
-	BlockHandle handle;
-	Slice input = index_value;
+	Status s;
 
-	Status s = handle.DecodeFrom(&input);
-	if(s.ok()){
-		BlockContents contents;
-		if(block_cache != NULL){
-			char cache_key_buffer[16];
-			//id + offset = cache key
-			EncodeFixed64(cache_key_buffer, table->rep_->cache_id);
-			EncodeFixed64(cache_key_buffer + 8, handle.offset());
-			Slice key(cache_key_buffer, sizeof(cache_key_buffer));
-			//LRU CACHEBLOCK
-			cache_handle = block_cache->Lookup(key);
-			if(cache_handle != NULL){//CACHEҵ
-				block = reinterpret_cast<Block*>(block_cache->Value(cache_handle));
-			}
-			else{//CACHEûҵڴжȡ
-				s = ReadBlock(table->rep_->file, opt, handle, &contents);
-				if(s.ok()){
-					s = ReadBlock(table->rep_->file, opt, handle, &contents);
-					if(s.ok()){
-							//
-						block = new Block(contents);
-						if(contents.cachable && opt.fill_cache) //Ӵеõblockд뵽lru cache
-							cache_handle = block_cache->Insert(key, block, block->size(), &DeleteCachedBlock);
-					}
-				}
-			}
+	BlockContents contents;
+	if(block_cache != NULL){
+		char cache_key_buffer[16];
+		Slice key = BlockCacheKey(rep_->cache_id, handle, cache_key_buffer);
+		//LRU CACHEBLOCK
+		cache_handle = block_cache->Lookup(key);
+		if(cache_handle != NULL){//CACHEҵ
+			block = reinterpret_cast<Block*>(block_cache->Value(cache_handle));
 		}
-		else{ //ѡcache,ֱӳжȡ
-			s = ReadBlock(table->rep_->file, opt, handle, &contents);
-			if(s.ok())
+		else{//CACHEûҵѹblock cacheߴжȡ
+			s = ReadBlockContents(opt, handle, &contents);
+			if(s.ok()){
+				//
 				block = new Block(contents);
+				if(contents.cachable && opt.fill_cache) //Ӵеõblockд뵽lru cache
+					cache_handle = block_cache->Insert(key, block, block->size(), &DeleteCachedBlock, priority);
+			}
 		}
 	}
+	else{ //ѡcache,ѹblock cacheߴжȡ
+		s = ReadBlockContents(opt, handle, &contents);
+		if(s.ok())
+			block = new Block(contents);
+	}
 	
-	//һblock
-	Iterator* iter = NULL;
-	if(block != NULL){
-		iter = block->NewIterator(table->rep_->options.comparator);
-		if(cache_handle == NULL) //cacheûcacheĲͬʽͷblock
-			iter->RegisterCleanup(&DeleteBlock, block, NULL);
-		else
-			iter->RegisterCleanup(&ReleaseBlock, block_cache, cache_handle);
+	if(block == NULL)
+		return NewErrorIterator(s);
+	return NewBlockIterator(block, cache_handle);
+}
+
+//block cacheûʱȡblockݣȲѹblock cacheͳ־ûcacheʱֻҪѹ
+//ûʱļȡͬʱѹblock cacheͳ־ûcache
+Status Table::ReadBlockContents(const ReadOptions& opt, const BlockHandle& handle, BlockContents* contents) const
+{
+	if(!HasSecondaryCache())
+		return ReadBlock(rep_->file, opt, handle, contents, rep_->zstd_dict);
+
+	if(LookupSecondaryBlock(opt, handle, contents))
+		return Status::OK();
+
+	std::string raw;
+	Status s = ReadBlock(rep_->file, opt, handle, contents, rep_->zstd_dict, opt.fill_cache ? &raw : NULL);
+	if(s.ok() && opt.fill_cache)
+		InsertSecondaryBlock(handle, &raw);
+	return s;
+}
+
+bool Table::HasSecondaryCache() const
+{
+	return rep_->options.block_cache_compressed != NULL || rep_->persistent_cache != NULL;
+}
+
+//ѹblock cacheͳ־ûcacheв
+bool Table::LookupSecondaryBlock(const ReadOptions& opt, const BlockHandle& handle, BlockContents* contents) const
+{
+	if(rep_->options.block_cache_compressed != NULL && LookupCompressedBlock(handle, contents))
+		return true;
+	return rep_->persistent_cache != NULL && LookupPersistentBlock(opt, handle, contents);
+}
+
+//־ûcacheеkeyļͬʱļСһҲͬDBؽþݵĿ
+static Slice PersistentCacheKey(uint64_t file_number, uint64_t file_size, const BlockHandle& handle, char* buf)
+{
+	EncodeFixed64(buf, file_number);
+	EncodeFixed64(buf + 8, file_size);
+	EncodeFixed64(buf + 16, handle.offset());
+	return Slice(buf, 24);
+}
+
+//ڳ־ûcacheвҲ룬еѹblockͬʱѹblock cache
+bool Table::LookupPersistentBlock(const ReadOptions& opt, const BlockHandle& handle, BlockContents* contents) const
+{
+	char key_buffer[24];
+	std::string raw;
+	if(!rep_->persistent_cache->Lookup(PersistentCacheKey(rep_->file_number, rep_->file_size, handle, key_buffer), &raw).ok())
+		return false;
+	if(!UncompressBlockContents(raw, contents, rep_->zstd_dict).ok())
+		return false;
+
+	if(rep_->options.block_cache_compressed != NULL && opt.fill_cache)
+		InsertCompressedBlock(handle, &raw);
+	return true;
+}
+
+//rawΪļblockԭʼ
+void Table::InsertSecondaryBlock(const BlockHandle& handle, std::string* raw) const
+{
+	if(raw->empty())
+		return;
+
+	//дʧֻٻһblockӰζȡ
+	if(rep_->persistent_cache != NULL){
+		char key_buffer[24];
+		rep_->persistent_cache->Insert(PersistentCacheKey(rep_->file_number, rep_->file_size, handle, key_buffer), *raw);
 	}
-	else
-		iter = NewErrorIterator(s);
 
+	if(rep_->options.block_cache_compressed != NULL)
+		InsertCompressedBlock(handle, raw);
+}
+
+//ѹblock cacheвҲѹûҵ߽ѹʧܷfalse
+bool Table::LookupCompressedBlock(const BlockHandle& handle, BlockContents* contents) const
+{
+	Cache* compressed_cache = rep_->options.block_cache_compressed;
+	char cache_key_buffer[16];
+	Cache::Handle* h = compressed_cache->Lookup(BlockCacheKey(rep_->compressed_cache_id, handle, cache_key_buffer));
+	if(h == NULL)
+		return false;
+
+	const std::string* raw = reinterpret_cast<const std::string*>(compressed_cache->Value(h));
+	Status s = UncompressBlockContents(*raw, contents, rep_->zstd_dict);
+	compressed_cache->Release(h);
+	return s.ok();
+}
+
+//ûѹblock룬block cacheѾͬĴС
+void Table::InsertCompressedBlock(const BlockHandle& handle, std::string* raw) const
+{
+	if(raw->empty() || (*raw)[raw->size() - 1] == kNoCompression)
+		return;
+
+	Cache* compressed_cache = rep_->options.block_cache_compressed;
+	std::string* value = new std::string;
+	value->swap(*raw);
+
+	char cache_key_buffer[16];
+	Cache::Handle* h = compressed_cache->Insert(BlockCacheKey(rep_->compressed_cache_id, handle, cache_key_buffer),
+		value, value->size(), &DeleteCachedCompressedBlock);
+	compressed_cache->Release(h);
+}
+
+//һblockcache_handleΪNULLʱӵblock
+Iterator* Table::NewBlockIterator(Block* block, Cache::Handle* cache_handle) const
+{
+	Iterator* iter = block->NewIterator(rep_->options.comparator);
+	if(cache_handle == NULL) //cacheûcacheĲͬʽͷblock
+		iter->RegisterCleanup(&DeleteBlock, block, NULL);
+	else
+		iter->RegisterCleanup(&ReleaseBlock, rep_->options.block_cache, cache_handle);
 	return iter;
 }
+
+//Ϊhandlesеÿdata blockblock cacheѹblock cacheͳ־ûcacheжûеblockͨReadBlocksһζȡ
+//blockĶ豸ϲִ
+void Table::ReadBlockIterators(const ReadOptions& opt, const std::vector<BlockHandle>& handles, std::vector<Iterator*>* iters) const
+{
+	Cache* block_cache = rep_->options.block_cache;
+	iters->assign(handles.size(), (Iterator*)NULL);
+
+	std::vector<size_t> missing;
+	std::vector<BlockContents> contents;
+	std::vector<Status> statuses;
+	std::vector<size_t> to_read;		//Ҫļȡblockmissingе±
+	for(size_t i = 0; i < handles.size(); i ++){
+		if(block_cache != NULL){
+			char cache_key_buffer[16];
+			Cache::Handle* cache_handle = block_cache->Lookup(BlockCacheKey(rep_->cache_id, handles[i], cache_key_buffer));
+			if(cache_handle != NULL){
+				(*iters)[i] = NewBlockIterator(reinterpret_cast<Block*>(block_cache->Value(cache_handle)), cache_handle);
+				continue;
+			}
+		}
+
+		//ѹblock cache߳־ûcacheеblockͶblockһblock cache
+		BlockContents c;
+		if(HasSecondaryCache() && LookupSecondaryBlock(opt, handles[i], &c)){
+			missing.push_back(i);
+			contents.push_back(c);
+			statuses.push_back(Status::OK());
+			continue;
+		}
+
+		to_read.push_back(missing.size());
+		missing.push_back(i);
+		contents.push_back(BlockContents());
+		statuses.push_back(Status::OK());
+	}
+
+	if(missing.empty())
+		return;
+
+	if(!to_read.empty()){
+		std::vector<BlockHandle> read_handles(to_read.size());
+		for(size_t k = 0; k < to_read.size(); k ++)
+			read_handles[k] = handles[missing[to_read[k]]];
+
+		std::vector<BlockContents> read_contents(to_read.size());
+		std::vector<Status> read_statuses(to_read.size());
+		std::vector<std::string> raws(to_read.size());
+		const bool fill_secondary = (HasSecondaryCache() && opt.fill_cache);
+		ReadBlocks(rep_->file, opt, &read_handles[0], read_handles.size(), &read_contents[0], &read_statuses[0], rep_->zstd_dict,
+			fill_secondary ? &raws[0] : NULL);
+
+		for(size_t k = 0; k < to_read.size(); k ++){
+			contents[to_read[k]] = read_contents[k];
+			statuses[to_read[k]] = read_statuses[k];
+			if(fill_secondary && read_statuses[k].ok())
+				InsertSecondaryBlock(read_handles[k], &raws[k]);
+		}
+	}
+
+	for(size_t j = 0; j < missing.size(); j ++){
+		if(!statuses[j].ok()){
+			(*iters)[missing[j]] = NewErrorIterator(statuses[j]);
+			continue;
+		}
+
+		Block* block = new Block(contents[j]);
+		Cache::Handle* cache_handle = NULL;
+		if(block_cache != NULL && contents[j].cachable && opt.fill_cache){
+			char cache_key_buffer[16];
+			cache_handle = block_cache->Insert(BlockCacheKey(rep_->cache_id, handles[missing[j]], cache_key_buffer),
+				block, block->size(), &DeleteCachedBlock, Cache::LOW);
+		}
+		(*iters)[missing[j]] = NewBlockIterator(block, cache_handle);
+	}
+}
+
+//ȡһdata block
+Iterator* Table::BlockReader(void* arg, const ReadOptions& opt, const Slice& index_value)
+{
+	Table* table = reinterpret_cast<Table*>(arg);
+	//λ
+	BlockHandle handle;
+	Slice input = index_value;
+	Status s = handle.DecodeFrom(&input);
+	if(!s.ok())
+		return NewErrorIterator(s);
+
+	return table->ReadBlockIterator(opt, handle, Cache::LOW);
+}
+
+//ȡһindexvalueindexhandleǰܸŹhandle
+Iterator* Table::PartitionReader(void* arg, const ReadOptions& opt, const Slice& index_value)
+{
+	Table* table = reinterpret_cast<Table*>(arg);
+	BlockHandle handle;
+	Slice input = index_value;
+	Status s = handle.DecodeFrom(&input);
+	if(!s.ok())
+		return NewErrorIterator(s);
+
+	//indexindex blockһԸȼblock cache
+	return table->ReadBlockIterator(opt, handle, Cache::HIGH);
+}
+
+Iterator* Table::NewIndexIterator(const ReadOptions& opt) const
+{
+	Block* index_block = NULL;
+	Cache::Handle* index_handle = NULL;
+	Status s = GetIndexBlock(&index_block, &index_handle);
+	if(!s.ok())
+		return NewErrorIterator(s);
+
+	Iterator* index_iter = index_block->NewIterator(rep_->options.comparator);
+	//index blockblock cacheʱʱͷhandle
+	if(index_handle != NULL)
+		index_iter->RegisterCleanup(&ReleaseBlock, rep_->options.block_cache, index_handle);
+
+	if(rep_->partitioned_index)
+		index_iter = NewTwoLevelIterator(index_iter, &Table::PartitionReader, const_cast<Table*>(this), opt);
+
+	return index_iter;
+}
+
+//Ԥ״̬ÿһ
+//data blockļţǰblockһblockʱΪ˳ȡ
+static const size_t kInitialReadaheadSize = 8 * 1024;
+static const size_t kMaxAutoReadaheadSize = 256 * 1024;
+
+struct Table::BlockReadahead
+{
+	Table* table;
+	const size_t fixed_size;	//ReadOptions::readahead_sizeΪ0ʱ⣬һֱСԤ
+	size_t size;				//ӦģʽһԤĴС
+	uint64_t prev_end;			//һblock(trailer)Ľλ
+	uint64_t limit;				//ѾԤλ
+	int num_sequential;
+
+	BlockReadahead(Table* t, size_t fixed) : table(t), fixed_size(fixed), size(kInitialReadaheadSize),
+		prev_end(~static_cast<uint64_t>(0)), limit(0), num_sequential(0){};
+
+	//ȡhandle֮ǰãشhandle.offset()ʼҪԤĳȣ0ʾҪ
+	size_t Next(const BlockHandle& handle)
+	{
+		const uint64_t offset = handle.offset();
+		if(offset == prev_end){
+			num_sequential ++;
+		}
+		else{ //ת¿ʼ
+			num_sequential = 0;
+			size = kInitialReadaheadSize;
+			limit = 0;
+		}
+		prev_end = offset + handle.size() + kBlockTrailerSize;
+
+		if(prev_end <= limit)
+			return 0;
+
+		if(fixed_size > 0){
+			limit = offset + fixed_size;
+			return fixed_size;
+		}
+
+		//blockԺſʼԤSeekֻһblockĳ˷IO
+		if(num_sequential < 2)
+			return 0;
+
+		const size_t n = size;
+		limit = offset + n;
+		size = std::min(size * 2, kMaxAutoReadaheadSize);
+		return n;
+	}
+};
+
+void Table::DeleteReadahead(void* arg, void* ignored)
+{
+	delete reinterpret_cast<BlockReadahead*>(arg);
+}
+
+//BlockReaderͬȡ֮ǰԤ״̬ʾļԤblock
+Iterator* Table::ReadaheadBlockReader(void* arg, const ReadOptions& opt, const Slice& index_value)
+{
+	BlockReadahead* readahead = reinterpret_cast<BlockReadahead*>(arg);
+	BlockHandle handle;
+	Slice input = index_value;
+	Status s = handle.DecodeFrom(&input);
+	if(!s.ok())
+		return NewErrorIterator(s);
+
+	const size_t n = readahead->Next(handle);
+	if(n > 0)
+		readahead->table->rep_->file->Prefetch(handle.offset(), n);
+
+	return readahead->table->ReadBlockIterator(opt, handle, Cache::LOW);
+}
+
 //һtwo level iter
 Iterator* Table::NewIterator(const ReadOptions& opt) const
 {
-	return NewTowLevelIterator(rep_->index_block->NewIterator(rep_->options.comparator), &Table::BlockReader,
-		const_cast<Table*>(this), opt);
+	BlockReadahead* readahead = new BlockReadahead(const_cast<Table*>(this), opt.readahead_size);
+	Iterator* iter = NewTwoLevelIterator(NewIndexIterator(opt), &Table::ReadaheadBlockReader, readahead, opt);
+	iter->RegisterCleanup(&DeleteReadahead, readahead, NULL);
+	return iter;
 }
 
-Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg, void (*saver)(void*, const Slice&, const Slice&))
+//ùkeyȡʧʱܴ
+bool Table::PartitionKeyMayMatch(const BlockHandle& filter_handle, const Slice& key) const
 {
-	Status s;
-	Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
-	iiter->Seek(k);
-	if(iiter->Valid()){
+	Cache* block_cache = rep_->options.block_cache;
+	if(block_cache == NULL){
+		BlockContents block;
+		if(!ReadBlock(rep_->file, ReadOptions(), filter_handle, &block).ok())
+			return true;
+
+		bool may_match = FullFilterBlockReader(rep_->options.filter_policy, block.data).KeyMayMatch(key);
+		if(block.heap_allocated)
+			delete []block.data.data();
+		return may_match;
+	}
+
+	char cache_key_buffer[16];
+	Slice cache_key = BlockCacheKey(rep_->cache_id, filter_handle, cache_key_buffer);
+	Cache::Handle* cache_handle = block_cache->Lookup(cache_key);
+	if(cache_handle == NULL){
+		BlockContents block;
+		if(!ReadBlock(rep_->file, ReadOptions(), filter_handle, &block).ok())
+			return true;
+
+		//mmapļķָӳڴ棬tableرԺʧЧŽblock cacheֱ̽
+		if(!block.cachable){
+			bool may_match = FullFilterBlockReader(rep_->options.filter_policy, block.data).KeyMayMatch(key);
+			if(block.heap_allocated)
+				delete []block.data.data();
+			return may_match;
+		}
+
+		CachedFullFilter* f = new CachedFullFilter;
+		f->data = block.data.data();
+		f->reader = new FullFilterBlockReader(rep_->options.filter_policy, block.data);
+		cache_handle = block_cache->Insert(cache_key, f, block.data.size(), &DeleteCachedFullFilter, Cache::HIGH);
+	}
+
+	bool may_match = reinterpret_cast<CachedFullFilter*>(block_cache->Value(cache_handle))->reader->KeyMayMatch(key);
+	block_cache->Release(cache_handle);
+	return may_match;
+}
+
+bool Table::KeyMayMatch(const Slice& k) const
+{
+	Cache::Handle* filter_handle = NULL;
+	FilterBlockReader* filter = GetFilter(&filter_handle);
+	bool may_match = true;
+	if(filter != NULL && filter->whole_table())
+		may_match = filter->KeyMayMatch(0, k);
+
+	if(filter_handle != NULL)
+		rep_->options.block_cache->Release(filter_handle);
+	return may_match;
+}
+
+void Table::KeysMayMatch(const Slice* keys, int n, bool* results) const
+{
+	Cache::Handle* filter_handle = NULL;
+	FilterBlockReader* filter = GetFilter(&filter_handle);
+	if(filter != NULL && filter->whole_table()){
+		filter->KeysMayMatch(0, keys, n, results);
+	}
+	else{
+		for(int i = 0; i < n; i ++)
+			results[i] = true;
+	}
+
+	if(filter_handle != NULL)
+		rep_->options.block_cache->Release(filter_handle);
+}
+
+Status Table::InternalMultiGet(const ReadOptions& options, const Slice* keys, int n, void** args,
+							   void (*saver)(void*, const Slice&, const Slice&))
+{
+	//indexÿkeyҪȲ鶥indexͷInternalGetindexblock cache
+	if(rep_->partitioned_index){
+		Status s;
+		for(int i = 0; i < n && s.ok(); i ++)
+			s = InternalGet(options, keys[i], args[i], saver);
+		return s;
+	}
+
+	Block* index_block = NULL;
+	Cache::Handle* index_handle = NULL;
+	Status s = GetIndexBlock(&index_block, &index_handle);
+	if(!s.ok())
+		return s;
+
+	Cache::Handle* filter_handle = NULL;
+	FilterBlockReader* filter = GetFilter(&filter_handle);
+	Iterator* iiter = index_block->NewIterator(rep_->options.comparator);
+
+	//һͨindex͹ȷÿkeyҪdata blockkeyͬblockֻ¼һ
+	std::vector<BlockHandle> handles;
+	std::vector<int> key_block(n, -1);
+	for(int i = 0; i < n; i ++){
+		iiter->Seek(keys[i]);
+		if(!iiter->Valid())
+			break; //key󣬶table
+
 		Slice handle_value = iiter->value();
-		FilterBlockReader* filter = rep_->filter;
 		BlockHandle handle;
+		s = handle.DecodeFrom(&handle_value);
+		if(!s.ok())
+			break;
 
-		//
-		if(filter != NULL && handle.DecodeFrom(&handle_value).ok() && !filter->KeyMayMatch(handle.offset(), k)){
-			//δҵ
-		}
-		else{
-			//ȡdata blockseekKEYλãSAVE
-			Iterator* block_iter = BlockReader(this, options, iiter->value());
-			block_iter->Seek(k);
-			if(block_iter->Valid())
-				(*saver)(arg, block_iter->key(), block_iter->value());
+		if(filter != NULL && !filter->whole_table() && !filter->KeyMayMatch(handle.offset(), keys[i]))
+			continue;
 
-			s = block_iter->status();
-			delete block_iter;
-		}
+		if(handles.empty() || handles.back().offset() != handle.offset())
+			handles.push_back(handle);
+		key_block[i] = static_cast<int>(handles.size()) - 1;
 	}
 
 	if(s.ok())
 		s = iiter->status();
-
 	delete iiter;
 
+	//ڶһζȡҪblockڸԵblockвkey
+	if(s.ok() && !handles.empty()){
+		std::vector<Iterator*> block_iters;
+		ReadBlockIterators(options, handles, &block_iters);
+
+		for(int i = 0; i < n && s.ok(); i ++){
+			if(key_block[i] < 0)
+				continue;
+
+			Iterator* block_iter = block_iters[key_block[i]];
+			block_iter->Seek(keys[i]);
+			if(block_iter->Valid())
+				(*saver)(args[i], block_iter->key(), block_iter->value());
+			s = block_iter->status();
+		}
+
+		for(size_t j = 0; j < block_iters.size(); j ++)
+			delete block_iters[j];
+	}
+
+	if(filter_handle != NULL)
+		rep_->options.block_cache->Release(filter_handle);
+	if(index_handle != NULL)
+		rep_->options.block_cache->Release(index_handle);
+
+	return s;
+}
+
+Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg, void (*saver)(void*, const Slice&, const Slice&))
+{
+	Block* index_block = NULL;
+	Cache::Handle* index_handle = NULL;
+	Status s = GetIndexBlock(&index_block, &index_handle);
+	if(!s.ok())
+		return s;
+
+	Cache::Handle* filter_handle = NULL;
+	Iterator* iiter = index_block->NewIterator(rep_->options.comparator);
+	if(rep_->partitioned_index){
+		//ڶindexжλųҪȡindex
+		Iterator* top_iter = iiter;
+		iiter = NULL;
+		top_iter->Seek(k);
+		if(top_iter->Valid()){
+			Slice input = top_iter->value();
+			BlockHandle partition_handle, partition_filter_handle;
+			s = partition_handle.DecodeFrom(&input);
+			if(s.ok()){
+				if(!rep_->partitioned_filter || !partition_filter_handle.DecodeFrom(&input).ok()
+					|| PartitionKeyMayMatch(partition_filter_handle, k))
+					iiter = ReadBlockIterator(options, partition_handle, Cache::HIGH);
+			}
+		}
+
+		if(s.ok())
+			s = top_iter->status();
+		delete top_iter;
+	}
+
+	if(iiter != NULL){
+		iiter->Seek(k);
+		if(iiter->Valid()){
+			Slice handle_value = iiter->value();
+			FilterBlockReader* filter = GetFilter(&filter_handle);
+			BlockHandle handle;
+
+			//飬tableĹѾTableCache::Getм
+			if(filter != NULL && !filter->whole_table() && handle.DecodeFrom(&handle_value).ok() && !filter->KeyMayMatch(handle.offset(), k)){
+				//δҵ
+			}
+			else{
+				//ȡdata blockseekKEYλãSAVE
+				Iterator* block_iter = BlockReader(this, options, iiter->value());
+				block_iter->Seek(k);
+				if(block_iter->Valid())
+					(*saver)(arg, block_iter->key(), block_iter->value());
+
+				s = block_iter->status();
+				delete block_iter;
+			}
+		}
+
+		if(s.ok())
+			s = iiter->status();
+
+		delete iiter;
+	}
+
+	if(filter_handle != NULL)
+		rep_->options.block_cache->Release(filter_handle);
+	if(index_handle != NULL)
+		rep_->options.block_cache->Release(index_handle);
+
 	return s;
 }
 
@@ -258,7 +945,7 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
 uint64_t Table::ApproximateOffsetOf(const Slice& key) const
 {
 	//λϢ
-	Iterator* index_iter = rep_->index_block->NewIterator(rep_->options.comparator);
+	Iterator* index_iter = NewIndexIterator(ReadOptions());
 	index_iter->Seek(key);
 	uint64_t result;
 	//ͨϢλƫ
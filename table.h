@@ -2,44 +2,84 @@
 #define __LEVEL_DB_TABLE_H_
 
 #include <stdint.h>
+#include <vector>
 #include "iterator.h"
+#include "cache.h"
 
 namespace leveldb{
 
 class Block;
 class BlockHandle;
+struct BlockContents;
 class Footer;
 struct Options;
 class ReadOptions;
 class RandomAccessFile;
 class TableCache;
+class FilterBlockReader;
 
 class Table
 {
 public:
-	static Status Open(const Options& options, RandomAccessFile* file, uint64_t file_size, Table** table);
+	//pin_index_and_filterֻoptions.cache_index_and_filter_blocksʱЧ
+	//indexfilterblock cacheһֱtableУᱻ̭
+	//file_numberΪtableļţɳ־ûcachekeyΪ0ʱtableʹoptions.persistent_cache
+	static Status Open(const Options& options, RandomAccessFile* file, uint64_t file_size, Table** table, bool pin_index_and_filter = false,
+		uint64_t file_number = 0);
 
 	~Table();
 
 	Iterator* NewIterator(const ReadOptions&) const;
+	//tableĹжkeyǷܴڣindexûֹʱtrue
+	bool KeyMayMatch(const Slice& key) const;
+	//汾results[i]Ϊkeys[i]Ľ
+	void KeysMayMatch(const Slice* keys, int n, bool* results) const;
 	uint64_t ApproximateOffsetOf(const Slice& key) const;
 
 private:
 	struct Rep;
 	Rep* rep_;
 
+	struct BlockReadahead;
+
 	friend class TableCache;
 
 private:
 	explicit Table(Rep* rep){rep_ = rep;};
 	
 	static Iterator* BlockReader(void *, const ReadOptions&, const Slice&);
+	//ʹõBlockReaderargΪBlockReadahead⵽˳ȡʱǰԤdata block
+	static Iterator* ReadaheadBlockReader(void *, const ReadOptions&, const Slice&);
+	static void DeleteReadahead(void* arg, void* ignored);
+	//indexʱindexvalueӦindexĵ
+	static Iterator* PartitionReader(void *, const ReadOptions&, const Slice&);
+	Iterator* ReadBlockIterator(const ReadOptions& opt, const BlockHandle& handle, Cache::Priority priority) const;
+	Iterator* NewBlockIterator(Block* block, Cache::Handle* cache_handle) const;
+	Status ReadBlockContents(const ReadOptions& opt, const BlockHandle& handle, BlockContents* contents) const;
+	bool LookupSecondaryBlock(const ReadOptions& opt, const BlockHandle& handle, BlockContents* contents) const;
+	bool LookupCompressedBlock(const BlockHandle& handle, BlockContents* contents) const;
+	bool LookupPersistentBlock(const ReadOptions& opt, const BlockHandle& handle, BlockContents* contents) const;
+	bool HasSecondaryCache() const;
+	void InsertSecondaryBlock(const BlockHandle& handle, std::string* raw) const;
+	void InsertCompressedBlock(const BlockHandle& handle, std::string* raw) const;
+	void ReadBlockIterators(const ReadOptions& opt, const std::vector<BlockHandle>& handles, std::vector<Iterator*>* iters) const;
+	//valueΪdata block handleindexindexʱǶindexͷɵtwo level iterator
+	Iterator* NewIndexIterator(const ReadOptions& opt) const;
+	bool PartitionKeyMayMatch(const BlockHandle& filter_handle, const Slice& key) const;
 
 	Status InternalGet(const ReadOptions&, const Slice& key, void* arg,
 		void (*hanlde_result)(void* arg, const Slice& k, const Slice&v));
+	//keysΪinternal keynkeyÿkeyһhandle_result(args[i], ...)߲()
+	//һindexͬһdata blockеkeyֻһblockblock cacheеblockһύ
+	Status InternalMultiGet(const ReadOptions&, const Slice* keys, int n, void** args,
+		void (*handle_result)(void* arg, const Slice& k, const Slice& v));
 
 	void ReadMeta(const Footer& footer);
 	void ReadFilter(const Slice& filter_handle_value);
+	void ReadCompressionDict(const Slice& dict_handle_value);
+
+	Status GetIndexBlock(Block** block, Cache::Handle** cache_handle) const;
+	FilterBlockReader* GetFilter(Cache::Handle** cache_handle) const;
 
 	Table(const Table&);
 	void operator=(const Table&);
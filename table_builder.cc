@@ -1,5 +1,8 @@
 #include "table_builder.h"
 #include <assert.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
 #include "comparator.h"
 #include "env.h"
 #include "filter_policy.h"
@@ -9,9 +12,109 @@
 #include "coding.h"
 #include "crc32c.h"
 #include "block_builder.h"
+#include "port.h"
+#include "mutexlock.h"
 
 namespace leveldb{
 
+//compression_per_levelΪʱѡ񣬳Ĳʹһ㲻ȷ(-1)ʱʹoptions.compression
+static CompressionType CompressionForLevel(const Options& opt, int level)
+{
+	if(level < 0 || opt.compression_per_level.empty())
+		return opt.compression;
+
+	const size_t i = std::min(static_cast<size_t>(level), opt.compression_per_level.size() - 1);
+	return opt.compression_per_level[i];
+}
+
+//typeѹrawѹʧ(ûбӦĿ)ѹʲ12.5%ʱѹ
+//ʵʵѹͣ*contentsָraw*compressed
+static CompressionType CompressBlock(CompressionType type, int zstd_level, void* zstd_cdict, const Slice& raw,
+									std::string* compressed, Slice* contents)
+{
+	bool compressed_ok = false;
+	switch(type){
+	case kNoCompression: //ѹ
+		break;
+
+	case kSnappyCompression:
+		compressed_ok = port::Snappy_Compress(raw.data(), raw.size(), compressed);
+		break;
+
+	case kLZ4Compression:
+		compressed_ok = port::LZ4_Compress(raw.data(), raw.size(), compressed);
+		break;
+
+	case kZstdCompression:
+		if(zstd_cdict != NULL)
+			compressed_ok = port::Zstd_CompressWithDict(zstd_cdict, raw.data(), raw.size(), compressed);
+		else
+			compressed_ok = port::Zstd_Compress(zstd_level, raw.data(), raw.size(), compressed);
+		break;
+	}
+
+	if(compressed_ok && compressed->size() < raw.size() - (raw.size() / 8u)){
+		*contents = *compressed;
+		return type;
+	}
+
+	*contents = raw;
+	return kNoCompression;
+}
+
+//blocktrailer1ֽѹ + 4ֽCRC(ݺ)
+static void EncodeBlockTrailer(const Slice& contents, CompressionType type, char* trailer)
+{
+	trailer[0] = type; //¼ѹģʽ
+	//CRC뵽trailer
+	uint32_t crc = crc32c::Value(contents.data(), contents.size());
+	crc = crc32c::Extend(crc, trailer, 1);
+	EncodeFixed32(trailer + 1, crc32c::Mask(crc));
+}
+
+//ѹһdata blockѹ߳дcontentstrailerdone
+//дtablḛ߳ύ˳ȡٲblockindex entry͹
+struct TableBuilder::BlockJob
+{
+	ParallelState* owner;
+	std::string raw;
+	std::string compressed;
+	Slice contents;
+	char trailer[kBlockTrailerSize];
+	bool done;			//owner->mu
+	bool cancelled;		//̳߳ضʱtableȡCompressionPool::mu
+
+	std::string first_key;
+	std::string last_key;
+	std::string keys;		//ҪkeyPutLengthPrefixedSlice
+};
+
+//TableBuilderѹ̳߳أ߳ڵһҪʱ֮һֱڣ
+//compactionÿļٸԴ̡߳߳ȡtableҪֵ
+struct TableBuilder::CompressionPool
+{
+	port::Mutex mu;
+	port::CondVar work_cv;		//µblock
+	std::deque<BlockJob*> work;
+	int threads;
+
+	CompressionPool() : work_cv(&mu), threads(0){};
+};
+
+//һTableBuilderĲѹ״̬һdata blockдʱ
+struct TableBuilder::ParallelState
+{
+	port::Mutex mu;
+	port::CondVar done_cv;		//tableblockѹ
+	CompressionPool* pool;
+
+	CompressionType type;
+	int zstd_level;
+	void* zstd_cdict;
+
+	ParallelState() : done_cv(&mu), pool(NULL){};
+};
+
 struct TableBuilder::Rep{
 	Options options;				//ѡ
 	Options index_block_options;	//indexѡoptionsһ
@@ -25,23 +128,60 @@ struct TableBuilder::Rep{
 	bool closed;
 	FilterBlockBuilder* filter_block;
 
+	//index͹index_blockΪǰindex
+	bool partitioned;
+	BlockBuilder top_index_block;			//indexkeyΪķָkeyvalueΪhandle + handle
+	FullFilterBlockBuilder* partition_filter;	//ǰindexǵkeyĹ
+
 	bool pending_index_entry;
 	BlockHandle pending_handle;
 
 	std::string compressed_output;		//Ϊsnappyʱ洢ĵط
 
-	Rep(const Options& opt, WritableFile* f) : options(opt), index_block_options(opt),
+	int level;
+	CompressionType compression;		//levelѡdata blockѹ
+
+	//ֵѹѵֵ֮ǰkey/valueȻbuffered_data(varint32 + key + varint32 + value)
+	bool buffering;
+	std::string buffered_data;
+	std::string compression_dict;
+	void* zstd_cdict;					//compression_dictZSTD_CDictûֵʱΪNULL
+
+	//ѹAddֻkeydata_blockindex entry͹block˳дʱ(EmitBlock)Ŵ
+	bool parallel;
+	ParallelState* parallel_state;
+	std::deque<BlockJob*> inflight;		//Ѿύûдblockύ˳
+	uint64_t inflight_bytes;			//inflightblockѹǰĴС(trailer)FileSize
+	std::string block_first_key;		//ǰdata blockĵһkey
+	std::string block_keys;				//ǰdata blockkeyйʱż¼
+	std::string emitted_last_key;		//дblockһkey
+
+	Rep(const Options& opt, WritableFile* f, int lvl) : options(opt), index_block_options(opt),
 		file(f), offset(0), data_block(&options), index_block(&options),
 		num_entries(0), closed(false), 
-		filter_block(opt.filter_policy == NULL ? NULL : new FilterBlockBuilder(opt.filter_policy)),
-		pending_index_entry(false)
+		filter_block(NULL), partitioned(opt.partition_index_and_filters), top_index_block(&index_block_options),
+		partition_filter(NULL),
+		pending_index_entry(false), level(lvl), compression(CompressionForLevel(opt, lvl)),
+		buffering(compression == kZstdCompression && opt.zstd_max_dict_bytes > 0), zstd_cdict(NULL),
+		parallel(opt.parallel_compression_threads > 1 && compression != kNoCompression), parallel_state(NULL),
+		inflight_bytes(0)
 	{
 		index_block_options.block_restart_interval = 1;
+
+		//tableһ >  > ÿ2KBһ
+		if(opt.filter_policy != NULL){
+			if(opt.whole_table_filter)
+				filter_block = new FilterBlockBuilder(opt.filter_policy, kWholeTableFilterBaseLg, lvl);
+			else if(opt.partition_index_and_filters)
+				partition_filter = new FullFilterBlockBuilder(opt.filter_policy, lvl);
+			else
+				filter_block = new FilterBlockBuilder(opt.filter_policy, 11, lvl);
+		}
 	}
 };
 
-TableBuilder::TableBuilder(const Options& options, WritableFile* file)
-	: rep_(new Rep(options, file))
+TableBuilder::TableBuilder(const Options& options, WritableFile* file, int level)
+	: rep_(new Rep(options, file, level))
 {
 	if(rep_->filter_block != NULL)
 		rep_->filter_block->StartBlock(0); //
@@ -50,7 +190,11 @@ TableBuilder::TableBuilder(const Options& options, WritableFile* file)
 TableBuilder::~TableBuilder()
 {
 	assert(rep_->closed);
+	ReleaseParallelState();
 	delete rep_->filter_block;
+	delete rep_->partition_filter;
+	if(rep_->zstd_cdict != NULL)
+		port::Zstd_DeleteCompressDict(rep_->zstd_cdict);
 	delete rep_;
 }
 
@@ -59,7 +203,14 @@ Status TableBuilder::ChangeOptions(const Options& opt)
 	if(opt.comparator != rep_->options.comparator) //Ƚƥ
 		return Status::InvalidArgument("changing comparator while building table");
 
+	if(opt.partition_index_and_filters != rep_->options.partition_index_and_filters)
+		return Status::InvalidArgument("changing index partitioning while building table");
+
+	if(opt.whole_table_filter != rep_->options.whole_table_filter)
+		return Status::InvalidArgument("changing filter layout while building table");
+
 	rep_->options = opt;
+	rep_->compression = CompressionForLevel(opt, rep_->level);
 	rep_->index_block_options = opt;
 	rep_->index_block_options.block_restart_interval = 1; //blockKEY
 
@@ -96,6 +247,31 @@ void TableBuilder::Add(const Slice& key, const Slice& value)
 	if(r->num_entries > 0)
 		assert(r->options.comparator->Compare(key, Slice(r->last_key)) > 0); //keyrepеlast key
 
+	//ѵֵ֮ǰֻ棬NumEntrieslast_keyճ£compactionǼ¼ļsmallest key
+	if(r->buffering){
+		PutLengthPrefixedSlice(&r->buffered_data, key);
+		PutLengthPrefixedSlice(&r->buffered_data, value);
+		r->last_key.assign(key.data(), key.size());
+		r->num_entries ++;
+		if(r->buffered_data.size() >= r->options.zstd_max_train_bytes)
+			EnterUnbuffered();
+		return;
+	}
+
+	if(r->parallel){
+		if(r->data_block.empty())
+			r->block_first_key.assign(key.data(), key.size());
+		if(r->filter_block != NULL || r->partition_filter != NULL)
+			PutLengthPrefixedSlice(&r->block_keys, key);
+
+		r->last_key.assign(key.data(), key.size());
+		r->num_entries ++;
+		r->data_block.Add(key, value);
+		if(r->data_block.CurrentSizeEstimate() >= r->options.block_size)
+			Flush();
+		return;
+	}
+
 	if(r->pending_index_entry){
 		assert(r->data_block.empty());
 		r->options.comparator->FindShortestSeparator(&r->last_key, key); //ҵr->last_keyСַͬСkeyılast key,
@@ -104,11 +280,17 @@ void TableBuilder::Add(const Slice& key, const Slice& value)
 		r->pending_handle.EncodeTo(&handle_encoding); //pending handle
 		r->index_block.Add(r->last_key, Slice(handle_encoding));//ݼ뵽index block
 		r->pending_index_entry = false;
+
+		//indexﵽСdata blockı߽з֣last_keyǷķָkey
+		if(r->partitioned && r->index_block.CurrentSizeEstimate() >= r->options.metadata_block_size)
+			FlushIndexPartition(r->last_key);
 	}
 
 	//key뵽
 	if(r->filter_block != NULL)
 		r->filter_block->AddKey(key);
+	if(r->partition_filter != NULL)
+		r->partition_filter->AddKey(key);
 
 	//last_key = key
 	r->last_key.assign(key.data(), key.size());
@@ -123,6 +305,50 @@ void TableBuilder::Add(const Slice& key, const Slice& value)
 	}
 }
 
+//ûkey/valueѵֵ䣬ٰǰ¼
+void TableBuilder::EnterUnbuffered()
+{
+	Rep* r = rep_;
+	assert(r->buffering);
+	r->buffering = false;
+
+	//block_sizeгɺʵдʱһԭʼdata blockΪ
+	std::string samples;
+	std::vector<size_t> sample_sizes;
+	BlockBuilder sample_block(&r->options);
+	Slice input(r->buffered_data);
+	Slice key, value;
+	while(GetLengthPrefixedSlice(&input, &key) && GetLengthPrefixedSlice(&input, &value)){
+		sample_block.Add(key, value);
+		if(sample_block.CurrentSizeEstimate() >= r->options.block_size){
+			Slice raw = sample_block.Finish();
+			samples.append(raw.data(), raw.size());
+			sample_sizes.push_back(raw.size());
+			sample_block.Reset();
+		}
+	}
+	if(!sample_block.empty()){
+		Slice raw = sample_block.Finish();
+		samples.append(raw.data(), raw.size());
+		sample_sizes.push_back(raw.size());
+	}
+
+	//̫ѵʧʱֵ
+	if(port::Zstd_TrainDictionary(samples, sample_sizes, r->options.zstd_max_dict_bytes, &r->compression_dict))
+		r->zstd_cdict = port::Zstd_NewCompressDict(r->compression_dict.data(), r->compression_dict.size(), r->options.zstd_compression_level);
+	if(r->zstd_cdict == NULL)
+		r->compression_dict.clear();
+
+	std::string data;
+	data.swap(r->buffered_data);
+	r->num_entries = 0;
+	r->last_key.clear();
+
+	input = Slice(data);
+	while(ok() && GetLengthPrefixedSlice(&input, &key) && GetLengthPrefixedSlice(&input, &value))
+		Add(key, value);
+}
+
 //ݽflush̻
 void TableBuilder::Flush()
 {
@@ -136,6 +362,11 @@ void TableBuilder::Flush()
 	//ݿǿյ
 	if(r->data_block.empty())
 		return;
+
+	if(r->parallel){
+		SubmitBlock();
+		return;
+	}
 	
 	//pending index entryУ
 	assert(!r->pending_index_entry);
@@ -158,27 +389,11 @@ void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle)
 	Rep* r = rep_;
 	Slice raw = block->Finish(); //ݿдƸraw
 
+	//ֵֻdata blockindexmeta indexڶȡֵ֮ǰҪ
+	void* cdict = (block == &r->data_block ? r->zstd_cdict : NULL);
 	Slice block_contents;
-	CompressionType type = r->options.compression;
-	switch(type){
-	case kNoCompression: //ѹ
-		block_contents = raw;
-		break;
-
-		//snappyѹ
-	case kSnappyCompression:{
-			std::string* compressed = &r->compressed_output;
-			if(port::Snappy_Compress(raw.data(), raw.size(), compressed) &&
-				compressed->size() < raw.size() - (raw.size() / 8u)){
-				block_contents = *compressed;
-			}
-			else{ //ѹʧܣѹģʽд
-				block_contents = raw;
-				type = kNoCompression;
-			}
-			break;
-		}
-	}
+	CompressionType type = CompressBlock(r->compression, r->options.zstd_compression_level, cdict, raw,
+		&r->compressed_output, &block_contents);
 
 	WriteRawBlock(block_contents, type, handle);
 	r->compressed_output.clear();
@@ -186,6 +401,13 @@ void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle)
 }
 
 void TableBuilder::WriteRawBlock(const Slice& block_contents, CompressionType type, BlockHandle* handle)
+{
+	char trailer[kBlockTrailerSize];
+	EncodeBlockTrailer(block_contents, type, trailer);
+	AppendBlock(block_contents, trailer, handle);
+}
+
+void TableBuilder::AppendBlock(const Slice& block_contents, const char* trailer, BlockHandle* handle)
 {
 	Rep* r = rep_;
 	//λü¼, pending handle
@@ -194,13 +416,6 @@ void TableBuilder::WriteRawBlock(const Slice& block_contents, CompressionType ty
 	//дļpage cache
 	r->status = r->file->Append(block_contents);
 	if(r->status.ok()){
-		//formatβ
-		char trailer[kBlockTrailerSize];
-		trailer[0] = type; //¼ѹģʽ
-		//CRC뵽trailer
-		uint32_t crc = crc32c::Value(block_contents.data(), block_contents.size());
-		crc = crc32c::Extend(crc, trailer, 1);
-		EncodeFixed32(trailer + 1, crc32c::Mask(crc));
 		//βд
 		r->status = r->file->Append(Slice(trailer, kBlockTrailerSize));
 		if(r->status.ok())
@@ -208,15 +423,237 @@ void TableBuilder::WriteRawBlock(const Slice& block_contents, CompressionType ty
 	}
 }
 
+//ѹ̳߳أһֱڣͷ
+static port::OnceType compression_pool_once = LEVELDB_ONCE_INIT;
+static void* compression_pool = NULL;
+
+void TableBuilder::InitCompressionPool()
+{
+	compression_pool = new CompressionPool;
+}
+
+//عѹ̳߳أ߳threadsʱ
+TableBuilder::CompressionPool* TableBuilder::GetCompressionPool(Env* env, int threads)
+{
+	port::InitOnce(&compression_pool_once, &TableBuilder::InitCompressionPool);
+	CompressionPool* pool = reinterpret_cast<CompressionPool*>(compression_pool);
+
+	MutexLock l(&pool->mu);
+	while(pool->threads < threads){
+		pool->threads ++;
+		env->StartThread(&TableBuilder::CompressionThread, pool);
+	}
+	return pool;
+}
+
+void TableBuilder::CompressionThread(void* arg)
+{
+	CompressionPool* pool = reinterpret_cast<CompressionPool*>(arg);
+	while(true){
+		pool->mu.Lock();
+		while(pool->work.empty())
+			pool->work_cv.Wait();
+		BlockJob* job = pool->work.front();
+		pool->work.pop_front();
+		pool->mu.Unlock();
+
+		//jobtable֮ǰͷParallelStateֵ
+		ParallelState* p = job->owner;
+		const CompressionType type = CompressBlock(p->type, p->zstd_level, p->zstd_cdict, job->raw, &job->compressed, &job->contents);
+		EncodeBlockTrailer(job->contents, type, job->trailer);
+
+		p->mu.Lock();
+		job->done = true;
+		p->done_cv.SignalAll();
+		p->mu.Unlock();
+	}
+}
+
+//дdata blockѹ̳߳أдѾѹɵblock
+void TableBuilder::SubmitBlock()
+{
+	Rep* r = rep_;
+	if(r->parallel_state == NULL){
+		//ֵѵ֮Żᴴѹֱ߳ʹѵõֵ
+		ParallelState* p = new ParallelState;
+		p->type = r->compression;
+		p->zstd_level = r->options.zstd_compression_level;
+		p->zstd_cdict = r->zstd_cdict;
+		p->pool = GetCompressionPool(r->options.env, r->options.parallel_compression_threads);
+		r->parallel_state = p;
+	}
+
+	BlockJob* job = new BlockJob;
+	Slice raw = r->data_block.Finish();
+	job->owner = r->parallel_state;
+	job->raw.assign(raw.data(), raw.size());
+	job->done = false;
+	job->cancelled = false;
+	job->first_key.swap(r->block_first_key);
+	job->last_key = r->last_key;
+	job->keys.swap(r->block_keys);
+	r->data_block.Reset();
+	r->block_keys.clear();
+
+	CompressionPool* pool = r->parallel_state->pool;
+	pool->mu.Lock();
+	pool->work.push_back(job);
+	pool->work_cv.Signal();
+	pool->mu.Unlock();
+
+	r->inflight.push_back(job);
+	r->inflight_bytes += job->raw.size() + kBlockTrailerSize;
+	EmitFinishedBlocks(false);
+}
+
+//ύ˳дѹɵblockwait_allΪtrueʱȴ;block
+//ֻ;blockʱȴƻڴ
+void TableBuilder::EmitFinishedBlocks(bool wait_all)
+{
+	Rep* r = rep_;
+	ParallelState* p = r->parallel_state;
+	if(p == NULL)
+		return;
+
+	const size_t max_inflight = 4 * static_cast<size_t>(r->options.parallel_compression_threads);
+	p->mu.Lock();
+	while(!r->inflight.empty()){
+		BlockJob* job = r->inflight.front();
+		if(!job->done){
+			if(!wait_all && r->inflight.size() <= max_inflight)
+				break;
+			p->done_cv.Wait();
+			continue;
+		}
+
+		r->inflight.pop_front();
+		r->inflight_bytes -= job->raw.size() + kBlockTrailerSize;
+		p->mu.Unlock();
+		EmitBlock(job);
+		delete job;
+		p->mu.Lock();
+	}
+	p->mu.Unlock();
+}
+
+//дһѹõdata blockͬģʽAdd/Flush˳һ£
+//Ȳһblockindex entry(ָkeyҪblockĵһkey)ټд
+void TableBuilder::EmitBlock(BlockJob* job)
+{
+	Rep* r = rep_;
+	if(!ok())
+		return;
+
+	if(r->pending_index_entry){
+		r->options.comparator->FindShortestSeparator(&r->emitted_last_key, job->first_key);
+		std::string handle_encoding;
+		r->pending_handle.EncodeTo(&handle_encoding);
+		r->index_block.Add(r->emitted_last_key, Slice(handle_encoding));
+		r->pending_index_entry = false;
+
+		if(r->partitioned && r->index_block.CurrentSizeEstimate() >= r->options.metadata_block_size)
+			FlushIndexPartition(r->emitted_last_key);
+	}
+
+	Slice input(job->keys);
+	Slice key;
+	while(GetLengthPrefixedSlice(&input, &key)){
+		if(r->filter_block != NULL)
+			r->filter_block->AddKey(key);
+		if(r->partition_filter != NULL)
+			r->partition_filter->AddKey(key);
+	}
+
+	AppendBlock(job->contents, job->trailer, &r->pending_handle);
+	if(ok()){
+		r->pending_index_entry = true;
+		r->status = r->file->Flush();
+	}
+
+	if(r->filter_block != NULL)
+		r->filter_block->StartBlock(r->offset);
+
+	r->emitted_last_key.swap(job->last_key);
+}
+
+//ͷŲѹ״̬ûдblock̳߳ضеblockֱȡѹblock
+void TableBuilder::ReleaseParallelState()
+{
+	Rep* r = rep_;
+	ParallelState* p = r->parallel_state;
+	if(p == NULL)
+		return;
+
+	CompressionPool* pool = p->pool;
+	pool->mu.Lock();
+	for(std::deque<BlockJob*>::iterator it = pool->work.begin(); it != pool->work.end();){
+		if((*it)->owner == p){
+			(*it)->cancelled = true;
+			it = pool->work.erase(it);
+		}
+		else
+			++it;
+	}
+	pool->mu.Unlock();
+
+	p->mu.Lock();
+	for(size_t i = 0; i < r->inflight.size(); i ++){
+		while(!r->inflight[i]->done && !r->inflight[i]->cancelled)
+			p->done_cv.Wait();
+	}
+	p->mu.Unlock();
+
+	for(size_t i = 0; i < r->inflight.size(); i ++)
+		delete r->inflight[i];
+	r->inflight.clear();
+	r->inflight_bytes = 0;
+
+	delete p;
+	r->parallel_state = NULL;
+}
+
+//д뵱ǰindexͶӦĹڶindexм¼ǵλ
+void TableBuilder::FlushIndexPartition(const Slice& separator)
+{
+	Rep* r = rep_;
+	if(!ok() || r->index_block.empty())
+		return;
+
+	BlockHandle partition_handle, filter_handle;
+	WriteBlock(&r->index_block, &partition_handle);
+	if(ok() && r->partition_filter != NULL){
+		WriteRawBlock(r->partition_filter->Finish(), kNoCompression, &filter_handle);
+		r->partition_filter->Reset();
+	}
+
+	if(ok()){
+		std::string handle_encoding;
+		partition_handle.EncodeTo(&handle_encoding);
+		if(r->partition_filter != NULL)
+			filter_handle.EncodeTo(&handle_encoding);
+		r->top_index_block.Add(separator, Slice(handle_encoding));
+	}
+}
+
 Status TableBuilder::Finish()
 {
 	Rep* r = rep_;
+	//tableûдﵽzstd_max_train_bytesеѵ
+	if(r->buffering)
+		EnterUnbuffered();
 	Flush(); //дļ
+	//ѹʱеdata blockд֮indexmeta blockڵǰ߳д
+	EmitFinishedBlocks(true);
+	ReleaseParallelState();
 
 	assert(!r->closed);
 	r->closed = true;
 
-	BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle;
+	BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle, dict_block_handle;
+
+	//ֵԭд
+	if(ok() && !r->compression_dict.empty())
+		WriteRawBlock(r->compression_dict, kNoCompression, &dict_block_handle);
 	
  // Write filter block
   if (ok() && r->filter_block != NULL) {
@@ -226,6 +663,12 @@ Status TableBuilder::Finish()
 	//дmeta index block,Ҫǹ˵ֺ͹λ
 	if(ok()){
 		BlockBuilder meta_index_block(&r->options);
+		if(!r->compression_dict.empty()){
+			std::string handle_encoding;
+			dict_block_handle.EncodeTo(&handle_encoding);
+			meta_index_block.Add(kCompressionDictBlockName, handle_encoding);
+		}
+
 		if(r->filter_block != NULL){
 			//һkey
 			std::string key = "filter.";
@@ -236,6 +679,17 @@ Status TableBuilder::Finish()
 			meta_index_block.Add(key, handle_encoding);
 		}
 
+		//indexıǣλü¼ڶindexУֻ¼֡
+		//meta index blockеkeyҪ
+		if(r->partitioned){
+			meta_index_block.Add("index.partitioned", Slice());
+			if(r->partition_filter != NULL){
+				std::string key = "partitionedfilter.";
+				key.append(r->options.filter_policy->name());
+				meta_index_block.Add(key, Slice());
+			}
+		}
+
 		WriteBlock(&meta_index_block, &metaindex_block_handle);
 	}
 
@@ -248,8 +702,17 @@ Status TableBuilder::Finish()
 			r->index_block.Add(r->last_key, Slice(handle_encoding)); //Ϊkey value뵽index block
 			r->pending_index_entry = false;
 		}
-		//Ϣдļ
-		WriteBlock(&r->index_block, &index_block_handle);
+
+		if(r->partitioned){
+			//һfooterеindex handleָ򶥲index
+			FlushIndexPartition(r->last_key);
+			if(ok())
+				WriteBlock(&r->top_index_block, &index_block_handle);
+		}
+		else{
+			//Ϣдļ
+			WriteBlock(&r->index_block, &index_block_handle);
+		}
 	}
 
 	//metaindex_block_handle index_block_handleݽļд footerд
@@ -272,9 +735,11 @@ uint64_t TableBuilder::NumEntries() const
 	return rep_->num_entries;
 }
 
+//ڼûԭʼݹļСcompactionзļ
 uint64_t TableBuilder::FileSize() const
 {
-	return rep_->offset;
+	//ѹʱûдblockѹǰĴСƣcompactionݴ˼ʱлļ
+	return rep_->offset + rep_->buffered_data.size() + rep_->inflight_bytes;
 }
 
 };//leveldb
@@ -13,7 +13,8 @@ class WritableFile;
 class TableBuilder
 {
 public:
-	TableBuilder(const Options& ops, WritableFile* file);
+	//levelΪtableҪдĲ(memtableдΪ0)-1ʾȷڰù
+	TableBuilder(const Options& ops, WritableFile* file, int level = -1);
 	~TableBuilder();
 
 	Status ChangeOptions(const Options& ops);
@@ -31,7 +32,22 @@ public:
 private:
 	bool ok() const;
 	void WriteBlock(BlockBuilder* block, BlockHandle* handle);
+	void EnterUnbuffered();
 	void WriteRawBlock(const Slice& data, CompressionType type, BlockHandle* handle);
+	void AppendBlock(const Slice& data, const char* trailer, BlockHandle* handle);
+
+	//ѹ
+	struct BlockJob;
+	struct ParallelState;
+	struct CompressionPool;
+	static void InitCompressionPool();
+	static CompressionPool* GetCompressionPool(Env* env, int threads);
+	static void CompressionThread(void* arg);
+	void SubmitBlock();
+	void EmitFinishedBlocks(bool wait_all);
+	void EmitBlock(BlockJob* job);
+	void ReleaseParallelState();
+	void FlushIndexPartition(const Slice& separator);
 
 	TableBuilder(const TableBuilder&);
 	void operator=(const TableBuilder&);
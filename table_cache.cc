@@ -1,4 +1,5 @@
 #include "table_cache.h"
+#include <vector>
 #include "filename.h"
 #include "env.h"
 #include "table.h"
@@ -20,6 +21,15 @@ static void DeleteEntry(const Slice& key, void* value)
 	delete tf;
 }
 
+//direct IO˽еtableʱͷ
+static void DeleteTableAndFile(void* arg1, void* arg2)
+{
+	Table* table = reinterpret_cast<Table*>(arg1);
+	RandomAccessFile* file = reinterpret_cast<RandomAccessFile*>(arg2);
+	delete table;
+	delete file;
+}
+
 static void UnrefEntry(void* arg1 ,void* arg2)
 {
 	Cache* cache = reinterpret_cast<Cache*>(arg1);
@@ -37,7 +47,51 @@ TableCache::~TableCache()
 	delete cache_;
 }
 
-Status TableCache::FindTable(uint64_t file_number, uint64_t file_size, Cache::Handle** handle)
+//ļtabledirectΪtrueʱdirect IOļ
+Status TableCache::OpenTable(uint64_t file_number, uint64_t file_size, int level, bool direct, RandomAccessFile** fileptr, Table** tableptr)
+{
+	//һ//dbname/number.ldbļ
+	std::string fname = TableFileName(dbname_, file_number);
+	RandomAccessFile* file = NULL;
+	Table* table = NULL;
+
+	Status s = direct ? env_->NewDirectRandomAccessFile(fname, &file) : env_->NewRandomAccessFile(fname, &file);
+	if(!s.ok()){ //ldbļʧ,Դsstļ
+		std::string old_fname = SSTableFileName(dbname_, file_number);
+		Status old_s = direct ? env_->NewDirectRandomAccessFile(old_fname, &file) : env_->NewRandomAccessFile(old_fname, &file);
+		if(old_s.ok())
+			s = Status::OK();
+	}
+
+	if(s.ok()){
+		//level 0ļÿζҪң԰indexfilter pinblock cache
+		const bool pin = (!direct && level == 0 && options_->pin_l0_filter_and_index_blocks_in_cache);
+		if(direct){
+			//direct IOtableǵ˽еģcache idбĶߣŽblock cacheѹblock cache
+			//indexfilterֻἷõblockʹcacheindextableԼУ
+			//õҲȡ
+			Options opt = *options_;
+			opt.block_cache = NULL;
+			opt.block_cache_compressed = NULL;
+			opt.filter_policy = NULL;
+			s = Table::Open(opt, file, file_size, &table, false, file_number);
+		}
+		else
+			s = Table::Open(*options_, file, file_size, &table, pin, file_number); //ļжȡݹTABALE
+	}
+
+	if(!s.ok()){
+		assert(table == NULL);
+		delete file;
+		file = NULL;
+	}
+
+	*fileptr = file;
+	*tableptr = table;
+	return s;
+}
+
+Status TableCache::FindTable(uint64_t file_number, uint64_t file_size, int level, Cache::Handle** handle)
 {
 	Status s;
 	char buf[sizeof(file_number)];
@@ -47,27 +101,11 @@ Status TableCache::FindTable(uint64_t file_number, uint64_t file_size, Cache::Ha
 	Slice key(buf, sizeof(buf));
 	*handle = cache_->Lookup(key);
 	//cacheûм¼tableϢļеtableϢ¼cache
-	if(handle == NULL){
-		//һ//dbname/number.ldbļ
-		std::string fname = TableFileName(dbname_, file_number);
+	if(*handle == NULL){
 		RandomAccessFile* file = NULL;
 		Table* table = NULL;
-
-		s = env_->NewRandomAccessFile(fname, &file); //һдļ
-		if(!s.ok()){ //ldbļʧ,Դsstļ
-			std::string old_fname = SSTableFileName(dbname_, file_number);
-			if(env_->NewRandomAccessFile(old_fname, &file).ok())
-				s = Status.OK();
-		}
-
-		if(s.ok())
-			s = Table::Open(*options_, file, file_size, &table); //ļжȡݹTABALE
-
-		if(!s.ok()){
-			assert(table == NULL);
-			delete file;
-		}
-		else{
+		s = OpenTable(file_number, file_size, level, false, &file, &table);
+		if(s.ok()){
 			TableAndFile* tf = new TableAndFile();
 			tf->file = file;
 			tf->table = table;
@@ -81,13 +119,28 @@ Status TableCache::FindTable(uint64_t file_number, uint64_t file_size, Cache::Ha
 }
 
 //һtow level iterator
-Iterator* TableCache::NewIterator(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, Table** tableptr)
+Iterator* TableCache::NewIterator(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, Table** tableptr, int level)
 {
 	if(tableptr != NULL)
 		*tableptr = NULL;
 
+	//direct IOtabletable cacheǰ̨ĶȡҲdirect IO
+	if(opt.use_direct_io){
+		RandomAccessFile* file = NULL;
+		Table* table = NULL;
+		Status s = OpenTable(file_number, file_size, level, true, &file, &table);
+		if(!s.ok())
+			return NewErrorIterator(s);
+
+		Iterator* result = table->NewIterator(opt);
+		result->RegisterCleanup(&DeleteTableAndFile, table, file);
+		if(tableptr != NULL)
+			*tableptr = table;
+		return result;
+	}
+
 	Cache::Handle* handle = NULL;
-	Status s = FindTable(file_number, file_size, &handle); //һhandleü
+	Status s = FindTable(file_number, file_size, level, &handle); //һhandleü
 	if(!s.ok())
 		return NewErrorIterator(s);
 
@@ -104,19 +157,52 @@ Iterator* TableCache::NewIterator(const ReadOptions& opt, uint64_t file_number,
 
 //saverһarg,ڶk,tableвҵvalue
 Status TableCache::Get(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, const Slice& k, void* arg, 
-	void(*saver)(void*, const Slice&, const Slice&))
+	void(*saver)(void*, const Slice&, const Slice&), int level)
 {
 	Cache::Handle* handle = NULL;
-	Status s = FindTable(file_number, file_size, &handle);
+	Status s = FindTable(file_number, file_size, level, &handle);
 	if(s.ok()){
 		Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
-		s = t->InternalGet(opt, k ,arg, saver); //tableвһkӦvalue,saverз
+		//tableĹųkҪȡindexdata block
+		if(t->KeyMayMatch(k))
+			s = t->InternalGet(opt, k ,arg, saver); //tableвһkӦvalue,saverз
 		cache_->Release(handle);//ͷü
 	}
 
 	return s;
 }
 
+Status TableCache::MultiGet(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, const Slice* keys, int n, void** args,
+	void (*saver)(void*, const Slice&, const Slice&), int level)
+{
+	Cache::Handle* handle = NULL;
+	Status s = FindTable(file_number, file_size, level, &handle);
+	if(!s.ok())
+		return s;
+
+	Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+
+	//ȥtableĹųkeyʣµıԭ˳
+	bool* may_match = new bool[n];
+	t->KeysMayMatch(keys, n, may_match);
+
+	std::vector<Slice> match_keys;
+	std::vector<void*> match_args;
+	for(int i = 0; i < n; i ++){
+		if(may_match[i]){
+			match_keys.push_back(keys[i]);
+			match_args.push_back(args[i]);
+		}
+	}
+	delete []may_match;
+
+	if(!match_keys.empty())
+		s = t->InternalMultiGet(opt, &match_keys[0], static_cast<int>(match_keys.size()), &match_args[0], saver);
+
+	cache_->Release(handle);
+	return s;
+}
+
 void TableCache::Evict(uint64_t file_number)
 {
 	char buf[sizeof(file_number)];
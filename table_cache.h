@@ -18,14 +18,19 @@ public:
 	TableCache(const std::string& dbname, const Options* opt, int entries);
 	~TableCache();
 
-	Iterator* NewIterator(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, Table** tableptr = NULL);
+	//levelΪļڵĲ㣬-1ʾδ֪ھǷpinסlevel 0ļindexfilter
+	Iterator* NewIterator(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, Table** tableptr = NULL, int level = -1);
 	Status Get(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, const Slice& k, void* arg, 
-		void (*handle_result)(void*, const Slice&, const Slice&));
+		void (*handle_result)(void*, const Slice&, const Slice&), int level = -1);
+	//ͬһļвninternal keykeytableֻһΣtableĹж
+	Status MultiGet(const ReadOptions& opt, uint64_t file_number, uint64_t file_size, const Slice* keys, int n, void** args,
+		void (*handle_result)(void*, const Slice&, const Slice&), int level = -1);
 
 	void Evict(uint64_t file_number);
 
 private:
-	Status FindTable(uint64_t file_number, uint64_t file_size, Cache::Handle**);
+	Status FindTable(uint64_t file_number, uint64_t file_size, int level, Cache::Handle**);
+	Status OpenTable(uint64_t file_number, uint64_t file_size, int level, bool direct, RandomAccessFile** file, Table** table);
 private:
 	Env* const env_;
 	const std::string dbname_;
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <vector>
+#include "memtablerep.h"
+#include "dbformat.h"
+#include "arena.h"
+#include "port.h"
+#include "mutexlock.h"
+
+namespace leveldb{
+
+//std::sortstd::lower_boundʹõıȽϺ
+struct VectorRepLess
+{
+	const MemTableRep::KeyComparator& compare;
+	explicit VectorRepLess(const MemTableRep::KeyComparator& c) : compare(c){};
+	bool operator()(const char* a, const char* b) const
+	{
+		return compare(a, b) < 0;
+	}
+};
+
+//vector repֻ׷ӣʺȴд롢ٶȡ볡
+//bucket_ǰsorted_count_entryģ(Get/Contains/GetIterator)ʱȰ׷ӵĲ
+//ٺ򲿷ֹ鲢ֲ֮ңÿentryֻһ򣬶дʱĴǹ鲢
+//ֻԺеbucket_дڼĵԿһ
+class VectorRep : public MemTableRep
+{
+public:
+	VectorRep(const MemTableRep::KeyComparator& cmp, Arena* arena, size_t reserved_count)
+		: MemTableRep(arena), compare_(cmp), immutable_(false), sorted_count_(0)
+	{
+		bucket_.reserve(reserved_count);
+	}
+
+	virtual void Insert(const char* entry)
+	{
+		MutexLock l(&mutex_);
+		assert(!immutable_);
+		bucket_.push_back(entry);
+	}
+
+	//׷mutex_ı½УԶ߳ͬʱ
+	virtual void InsertConcurrently(const char* entry)
+	{
+		Insert(entry);
+	}
+
+	virtual bool Contains(const char* entry) const
+	{
+		MutexLock l(&mutex_);
+		SortLocked();
+		std::vector<const char*>::const_iterator it = std::lower_bound(bucket_.begin(), bucket_.end(), entry, VectorRepLess(compare_));
+		return it != bucket_.end() && compare_(*it, entry) == 0;
+	}
+
+	virtual void MarkReadOnly()
+	{
+		MutexLock l(&mutex_);
+		immutable_ = true;
+	}
+
+	virtual size_t ApproximateMemoryUsage()
+	{
+		MutexLock l(&mutex_);
+		return sizeof(*this) + bucket_.capacity() * sizeof(const char*);
+	}
+
+	//ֱbucket_϶ֲңcallbackֻentrymutex_µ
+	virtual void Get(const LookupKey& k, void* arg, bool (*callback)(void* arg, const char* entry))
+	{
+		MutexLock l(&mutex_);
+		SortLocked();
+
+		std::vector<const char*>::const_iterator it = 
+			std::lower_bound(bucket_.begin(), bucket_.end(), k.memtable_key().data(), VectorRepLess(compare_));
+		for(; it != bucket_.end() && callback(arg, *it); ++ it){
+		}
+	}
+
+	class Iterator : public MemTableRep::Iterator
+	{
+	public:
+		//ownedΪtrueʱbucketǵԼĿʱͷ
+		Iterator(const std::vector<const char*>* bucket, bool owned, const MemTableRep::KeyComparator& cmp)
+			: bucket_(bucket), owned_(owned), compare_(cmp), pos_(bucket->size()){};
+
+		virtual ~Iterator()
+		{
+			if(owned_)
+				delete bucket_;
+		}
+
+		virtual bool Valid() const { return pos_ < bucket_->size(); };
+
+		virtual const char* key() const
+		{
+			assert(Valid());
+			return (*bucket_)[pos_];
+		}
+
+		virtual void Next()
+		{
+			assert(Valid());
+			pos_ ++;
+		}
+
+		virtual void Prev()
+		{
+			assert(Valid());
+			if(pos_ == 0)
+				pos_ = bucket_->size();
+			else
+				pos_ --;
+		}
+
+		virtual void Seek(const char* target)
+		{
+			pos_ = std::lower_bound(bucket_->begin(), bucket_->end(), target, VectorRepLess(compare_)) - bucket_->begin();
+		}
+
+		virtual void SeekToFirst() { pos_ = 0; };
+
+		virtual void SeekToLast() { pos_ = bucket_->empty() ? 0 : bucket_->size() - 1; };
+
+	private:
+		const std::vector<const char*>* bucket_;
+		bool owned_;
+		const MemTableRep::KeyComparator& compare_;
+		size_t pos_;
+	};
+
+	virtual MemTableRep::Iterator* GetIterator()
+	{
+		MutexLock l(&mutex_);
+		SortLocked();
+
+		//ֻԺ󲻻в룬еbucket_
+		if(immutable_)
+			return new Iterator(&bucket_, false, compare_);
+
+		return new Iterator(new std::vector<const char*>(bucket_), true, compare_);
+	}
+
+private:
+	//ϴԺ׷ӵentry򲢹鲢򲿷֣߳mutex_
+	void SortLocked() const
+	{
+		if(sorted_count_ == bucket_.size())
+			return;
+
+		std::vector<const char*>::iterator middle = bucket_.begin() + sorted_count_;
+		std::sort(middle, bucket_.end(), VectorRepLess(compare_));
+		std::inplace_merge(bucket_.begin(), middle, bucket_.end(), VectorRepLess(compare_));
+		sorted_count_ = bucket_.size();
+	}
+
+private:
+	const MemTableRep::KeyComparator& compare_;
+	mutable port::Mutex mutex_;
+	//Ҳmutable
+	mutable std::vector<const char*> bucket_;
+	bool immutable_;
+	mutable size_t sorted_count_;
+};
+
+class VectorRepFactory : public MemTableRepFactory
+{
+public:
+	explicit VectorRepFactory(size_t reserved_count) : reserved_count_(reserved_count){};
+
+	virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp, Arena* arena)
+	{
+		return new VectorRep(cmp, arena, reserved_count_);
+	}
+
+	virtual const char* Name() const { return "VectorRepFactory"; };
+
+	virtual bool IsInsertConcurrentlySupported() const { return true; };
+
+private:
+	size_t reserved_count_;
+};
+
+MemTableRepFactory* NewVectorRepFactory(size_t reserved_count)
+{
+	return new VectorRepFactory(reserved_count);
+}
+
+};//leveldb
+
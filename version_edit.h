@@ -18,10 +18,12 @@ struct FileMetaData
 	uint64_t file_size;
 	InternalKey smallest;
 	InternalKey largest;
+	//ļڱĳCompactionʹãPickCompaction
+	bool being_compacted;
 
 	FileMetaData() 
 		: refs(0), allowed_seeks(1 << 30) //256M
-		, file_size(0)
+		, file_size(0), being_compacted(false)
 	{
 	}
 };
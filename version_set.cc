@@ -21,6 +21,8 @@ static const int kTargetFileSize = 2 * 1048576; //2M
 static const int64_t kMaxGrandParentOverlapBytes = 10 * kTargetFileSize; // 20M
 
 static const int64_t kExpandedCompactionByteSizeLimit = 25 * kTargetFileSize; // 50M
+//ÿcompactionٷֵôļС룬зֲֵöռһ̺߳Ͷļ
+static const int kMinSubcompactionInputFiles = 4;
 
 static double MaxBytesForLevel(int level)
 {
@@ -47,6 +49,17 @@ static int64_t TotalFileSize(const std::vector<FileMetaData*>& files)
 	return sum;
 }
 
+//жfilesǷļڱCompactionʹ
+static bool AnyFileBeingCompacted(const std::vector<FileMetaData*>& files)
+{
+	for(size_t i = 0; i < files.size(); i ++){
+		if(files[i]->being_compacted)
+			return true;
+	}
+
+	return false;
+}
+
 namespace{
 std::string IntSetToString(const std::set<uint64_t>& s)
 {
@@ -230,7 +243,7 @@ void Version::AddIterators(const ReadOptions& opt, std::vector<Iterator*>* iters
 	//level 0table cache
 	for(size_t i = 0; i < files_[0].size(); i ++){
 		//һtable cacheiter
-		Iterator* cache_iter = vset_->table_cache_->NewIterator(opt, files_[0][i]->number, files_[0][i]->file_size);
+		Iterator* cache_iter = vset_->table_cache_->NewIterator(opt, files_[0][i]->number, files_[0][i]->file_size, NULL, 0);
 		iters->push_back(cache_iter);
 	}
 
@@ -398,18 +411,19 @@ Status Version::Get(const ReadOptions& opt, const LookupKey& k, std::string* val
 			saver.user_key = user_key;
 			saver.value = value;
 			//table cacheнkey valueӲ
-			s = vset_->table_cache_->Get(opt, f->number, f->file_size, ikey, &saver, SaveValue);
+			s = vset_->table_cache_->Get(opt, f->number, f->file_size, ikey, &saver, SaveValue, level);
 			if(!s.ok())
 				return s;
 
+			//ҵ߱ɾʱٲϵļ
 			switch(saver.state){
 			case kNotFound:
 				break;
 			case kFound:
-				break;
+				return s;
 			case kDeleted:
 				s = Status::NotFound(Slice());
-				break;
+				return s;
 			case kCorrupt:
 				s = Status::Corruption("corrupted key for ", user_key);
 				return s;
@@ -419,6 +433,135 @@ Status Version::Get(const ReadOptions& opt, const LookupKey& k, std::string* val
 	return Status::NotFound(Slice());  // Use an empty error message for speed
 }
 
+//keysuser key㴦level 0ļµɣÿļһβΧڵδkey
+//ļصڵkeyļ飬ÿһTableCache::MultiGet
+void Version::MultiGet(const ReadOptions& opt, const LookupKey* const* keys, int n, std::string** values, Status** statuses, GetStats* stats)
+{
+	const Comparator* ucmp = vset_->icmp_.user_comparator();
+
+	stats->seek_file = NULL;
+	stats->seek_file_level = -1;
+
+	std::vector<Saver> savers(n);
+	std::vector<bool> done(n, false);
+	std::vector<FileMetaData*> last_file_read(n, (FileMetaData*)NULL);
+	std::vector<int> last_file_read_level(n, -1);
+	for(int i = 0; i < n; i ++){
+		savers[i].state = kNotFound;
+		savers[i].ucmp = ucmp;
+		savers[i].user_key = keys[i]->user_key();
+		savers[i].value = values[i];
+	}
+
+	int remaining = n;
+	std::vector<FileMetaData*> level0;
+	std::vector<int> batch;
+	std::vector<Slice> batch_keys;
+	std::vector<void*> batch_args;
+
+	for(int level = 0; level < config::kNumLevels && remaining > 0; level ++){
+		const std::vector<FileMetaData*>& files = files_[level];
+		if(files.empty())
+			continue;
+
+		if(level == 0){
+			level0 = files;
+			std::sort(level0.begin(), level0.end(), NewestFirst);
+		}
+
+		size_t next = 0;	//level > 0ʱһkey
+		size_t file_pos = 0;	//level 0ʱһļ
+		for(;;){
+			FileMetaData* f = NULL;
+			batch.clear();
+
+			if(level == 0){
+				if(file_pos >= level0.size())
+					break;
+
+				f = level0[file_pos ++];
+				for(int i = 0; i < n; i ++){
+					if(!done[i] && ucmp->Compare(savers[i].user_key, f->smallest.user_key()) >= 0
+						&& ucmp->Compare(savers[i].user_key, f->largest.user_key()) <= 0)
+						batch.push_back(i);
+				}
+			}
+			else{
+				while(next < static_cast<size_t>(n) && done[next])
+					next ++;
+				if(next >= static_cast<size_t>(n))
+					break;
+
+				const int index = FindFile(vset_->icmp_, files, keys[next]->internal_key());
+				if(index >= static_cast<int>(files.size()))
+					break; //keyһkey
+
+				f = files[index];
+				//ͬһļеkeyֱһļkeykey
+				for(; next < static_cast<size_t>(n); next ++){
+					if(done[next])
+						continue;
+					if(vset_->icmp_.Compare(keys[next]->internal_key(), f->largest.Encode()) > 0)
+						break;
+					if(ucmp->Compare(savers[next].user_key, f->smallest.user_key()) >= 0)
+						batch.push_back(static_cast<int>(next));
+				}
+			}
+
+			if(batch.empty())
+				continue;
+
+			batch_keys.clear();
+			batch_args.clear();
+			for(size_t j = 0; j < batch.size(); j ++){
+				const int i = batch[j];
+				if(last_file_read[i] != NULL && stats->seek_file == NULL){
+					stats->seek_file = last_file_read[i];
+					stats->seek_file_level = last_file_read_level[i];
+				}
+				last_file_read[i] = f;
+				last_file_read_level[i] = level;
+
+				batch_keys.push_back(keys[i]->internal_key());
+				batch_args.push_back(&savers[i]);
+			}
+
+			Status s = vset_->table_cache_->MultiGet(opt, f->number, f->file_size, &batch_keys[0], static_cast<int>(batch_keys.size()),
+				&batch_args[0], SaveValue, level);
+
+			for(size_t j = 0; j < batch.size(); j ++){
+				const int i = batch[j];
+				if(!s.ok()){
+					*statuses[i] = s;
+				}
+				else{
+					switch(savers[i].state){
+					case kNotFound:
+						continue;
+					case kFound:
+						*statuses[i] = Status::OK();
+						break;
+					case kDeleted:
+						*statuses[i] = Status::NotFound(Slice());
+						break;
+					case kCorrupt:
+						*statuses[i] = Status::Corruption("corrupted key for ", savers[i].user_key);
+						break;
+					}
+				}
+
+				done[i] = true;
+				remaining --;
+			}
+		}
+	}
+
+	for(int i = 0; i < n; i ++){
+		if(!done[i])
+			*statuses[i] = Status::NotFound(Slice());
+	}
+}
+
 //ļseekĸ
 bool Version::UpdateStats(const GetStats& stats)
 {
@@ -1002,6 +1145,7 @@ void VersionSet::Finalize(Version* v)
 			score = static_cast<double>(level_bytes) / MaxBytesForLevel(level);
 		}
 
+		v->compaction_scores_[level] = score;
 		if(score > best_score){
 			best_level = level;
 			best_score = score;
@@ -1173,6 +1317,8 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c)
 
 	options.verfy_checksums = options_->paranoid_checks;
 	options.fill_cache = false;
+	options.readahead_size = options_->compaction_readahead_size;
+	options.use_direct_io = options_->use_direct_io_for_compaction;
 
 	const int space = (c->level() == 0 ? c->inputs_[0].size() + 1 : 2);
 	Iterator** list = new Iterator*[space];
@@ -1183,7 +1329,7 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c)
 			if(c->level() + which == 0){
 				const std::vector<FileMetaData*>& files = c->inputs_[which];
 				for(size_t i = 0; i < files.size(); i ++)
-					list[num ++] = table_cache_->NewIterator(options, files[i]->number, files[i]->file_size);
+					list[num ++] = table_cache_->NewIterator(options, files[i]->number, files[i]->file_size, NULL, 0);
 			}
 			else{
 				list[num ++] = NewTwoLevelIterator(new Version::LevelFileNumIterator(icmp_, &c->inputs_[which]),
@@ -1200,61 +1346,116 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c)
 	return result;
 }
 
-//ѡϲݸscoreȷϲ
-Compaction* VersionSet::PickCompaction()
+//level㰴պϲѡһûбCompactionռõļCompaction
+Compaction* VersionSet::PickCompactionAtLevel(int level)
 {
-	Compaction* c;
-	int level;
+	assert(level >= 0);
+	assert(level + 1 < config::kNumLevels);
 
-	const bool size_compaction = (current_->compaction_score_ >= 1);
-	const bool seek_compaction = (current_->file_to_compact_ != NULL);
+	const std::vector<FileMetaData*>& files = current_->files_[level];
+	if(files.empty())
+		return NULL;
 
-	if(size_compaction){
-		level = current_->compaction_level_;
-		
-		assert(level >= 0);
-		assert(level + 1 < config::kNumLevels);
-		c = new Compaction(level);
-
-		//current levelûںϲϵfileӵCompaction
-		for(size_t i = 0; i < current_->files_[level].size(); i++){
-			FileMetaData* f = current_->files_[level][i];
-			if(compact_pointer_[level].empty() || icmp_.Compare(f->largest.Encode(), compact_pointer_[level]) > 0){
-				c->inputs_[0].push_back(f);
-				break;
-			}
-		}
+	//level 0ļ֮صͬһʱֻһlevel 0Compaction
+	if(level == 0 && AnyFileBeingCompacted(files))
+		return NULL;
 
-		//ϲcǿյģcurrent levelĵһfileȥ
-		if(c->inputs_[0].empty()){
-			c->inputs_[0].push_back(current_->files_[level][0]);
+	//ҵϲ֮ĵһļʼѭ
+	size_t start = 0;
+	for(; start < files.size(); start++){
+		if(compact_pointer_[level].empty() || icmp_.Compare(files[start]->largest.Encode(), compact_pointer_[level]) > 0)
+			break;
+	}
+
+	if(start == files.size())
+		start = 0;
+
+	for(size_t n = 0; n < files.size(); n++){
+		FileMetaData* f = files[(start + n) % files.size()];
+		if(f->being_compacted)
+			continue;
+
+		Compaction* c = new Compaction(level);
+		c->inputs_[0].push_back(f);
+		c->input_version_ = current_;
+		c->input_version_->Ref();
+
+		//memtable
+		if(level == 0){
+			InternalKey smallest, largest;
+			GetRange(c->inputs_[0], &smallest, &largest);
+			current_->GetOverlappingInputs(0, &smallest, &largest, &c->inputs_[0]);
+			assert(!c->inputs_[0].empty());
 		}
+
+		if(SetupOtherInputs(c))
+			return c;
+
+		//еCompactionгͻһļ
+		delete c;
+		if(level == 0)
+			break;
 	}
-	else if(seek_compaction){ //compaction,ֱӽfile_to_compact_뵽compaction
-		level = current_->file_to_compact_level_;
-		c = new Compaction(level);
-		c->inputs_[0].push_back(current_->file_to_compact_);
+
+	return NULL;
+}
+
+//ѡϲݸscoreȷϲscoreӸߵγԣ
+//ڱCompactionʹõļصCompactionԲִ
+Compaction* VersionSet::PickCompaction()
+{
+	Compaction* c = NULL;
+
+	int levels[config::kNumLevels - 1];
+	int num = 0;
+	for(int level = 0; level < config::kNumLevels - 1; level++){
+		if(current_->compaction_scores_[level] < 1)
+			continue;
+
+		//score
+		int i = num++;
+		while(i > 0 && current_->compaction_scores_[levels[i - 1]] < current_->compaction_scores_[level]){
+			levels[i] = levels[i - 1];
+			i--;
+		}
+		levels[i] = level;
 	}
-	else
-		return NULL;
 
-	c->input_version_ = current_;
-	c->input_version_->Ref();
+	for(int i = 0; i < num && c == NULL; i++)
+		c = PickCompactionAtLevel(levels[i]);
+
+	//size compactionûпģseek compaction
+	FileMetaData* f = current_->file_to_compact_;
+	if(c == NULL && f != NULL && !f->being_compacted){
+		const int level = current_->file_to_compact_level_;
+		if(level != 0 || !AnyFileBeingCompacted(current_->files_[0])){
+			c = new Compaction(level);
+			c->inputs_[0].push_back(f);
+			c->input_version_ = current_;
+			c->input_version_->Ref();
+
+			if(level == 0){
+				InternalKey smallest, largest;
+				GetRange(c->inputs_[0], &smallest, &largest);
+				current_->GetOverlappingInputs(0, &smallest, &largest, &c->inputs_[0]);
+				assert(!c->inputs_[0].empty());
+			}
 
-	//memtable
-	if(level == 0){
-		InternalKey smallest, largest;
-		GetRange(c->inputs_[0], &smallest, &largest);
-		current_->GetOverlappingInputs(0, &smallest, &largest, &c->inputs_[0]);
-		assert(!c->inputs_[0].empty());
+			if(!SetupOtherInputs(c)){
+				delete c;
+				c = NULL;
+			}
+		}
 	}
 
-	SetupOtherInputs(c);
+	if(c != NULL)
+		c->MarkFilesBeingCompacted(true);
 
 	return c;
 }
 
-void VersionSet::SetupOtherInputs(Compaction* c)
+//falseʾļеCompactionͻʱ޸ĺϲ
+bool VersionSet::SetupOtherInputs(Compaction* c)
 {
 	const int level = c->level();
 
@@ -1263,6 +1464,8 @@ void VersionSet::SetupOtherInputs(Compaction* c)
 
 	//level + 1صصfilesдc->inputs_[1]
 	current_->GetOverlappingInputs(level + 1, &smallest, &largest, &c->inputs_[1]);
+	if(AnyFileBeingCompacted(c->inputs_[0]) || AnyFileBeingCompacted(c->inputs_[1]))
+		return false;
 
 	//c->inputs_[0], c->inputs_[1]ļпʼkeyͽkey
 	InternalKey all_start, all_limit;
@@ -1286,7 +1489,8 @@ void VersionSet::SetupOtherInputs(Compaction* c)
 			current_->GetOverlappingInputs(level + 1, &new_start, &new_limit, &expanded1);
 
 			//ҪCompationļc趨һֻǷΧıˣΧ
-			if(expanded1.size() == c->inputs_[1].size()){
+			if(expanded1.size() == c->inputs_[1].size() 
+				&& !AnyFileBeingCompacted(expanded0) && !AnyFileBeingCompacted(expanded1)){
 				Log(options_->info_log,
 					"Expanding@%d %d+%d (%ld+%ld bytes) to %d+%d (%ld+%ld bytes)\n",
 					level,
@@ -1322,6 +1526,8 @@ void VersionSet::SetupOtherInputs(Compaction* c)
 	//Compact
 	compact_pointer_[level] = largest.Encode().ToString();
 	c->edit_.SetCompactPointer(level, largest);
+
+	return true;
 }
 
 //ϲָcurrent_Χ
@@ -1354,11 +1560,123 @@ Compaction* VersionSet::CompactRange(int level, const InternalKey* begin, const
 	c->input_version_->Ref();
 	c->inputs_[0] = inputs;
 
-	SetupOtherInputs(c);
+	//ֶCompactionǶռִеģCompactionͻ
+	if(!SetupOtherInputs(c)){
+		delete c;
+		return NULL;
+	}
+
+	c->MarkFilesBeingCompacted(true);
+	return c;
+}
+
+struct UserKeyLess
+{
+	const Comparator* ucmp;
+	bool operator()(const std::string& a, const std::string& b) const { return ucmp->Compare(a, b) < 0; }
+};
+
+//жļfǷuser key[start, end)ص
+static bool FileInShard(const Comparator* ucmp, const FileMetaData* f, const std::string* start, const std::string* end)
+{
+	if(start != NULL && ucmp->Compare(f->largest.user_key(), Slice(*start)) < 0)
+		return false;
+
+	if(end != NULL && ucmp->Compare(f->smallest.user_key(), Slice(*end)) >= 0)
+		return false;
+
+	return true;
+}
+
+//cļgrandparentļı߽зΪmax_shardsصuser key䣬
+//ÿһCompactionɲ̸ͬ߳ԴԵļ
+//ͬһuser keyа汾һͬһڣԶɰ汾߼Ӱ졣
+//Сƣ벻2 * kMinSubcompactionInputFilesļСʱз֡
+//ҪзʱshardsΪ
+void VersionSet::SplitCompaction(Compaction* c, int max_shards, std::vector<Compaction*>* shards)
+{
+	shards->clear();
+
+	const uint64_t input_bytes = TotalFileSize(c->inputs_[0]) + TotalFileSize(c->inputs_[1]);
+	const uint64_t max_shards_by_size = input_bytes / (kMinSubcompactionInputFiles * c->max_output_file_size_);
+	if(max_shards_by_size < static_cast<uint64_t>(max_shards))
+		max_shards = static_cast<int>(max_shards_by_size);
+
+	if(max_shards <= 1)
+		return;
+
+	const Comparator* ucmp = icmp_.user_comparator();
+
+	//ѡ߽Ϊļsmallest user key
+	std::vector<std::string> bounds;
+	for(int which = 0; which < 2; which ++){
+		for(size_t i = 0; i < c->inputs_[which].size(); i++)
+			bounds.push_back(c->inputs_[which][i]->smallest.user_key().ToString());
+	}
+	for(size_t i = 0; i < c->grandparents_.size(); i++)
+		bounds.push_back(c->grandparents_[i]->smallest.user_key().ToString());
+
+	UserKeyLess less = { ucmp };
+	std::sort(bounds.begin(), bounds.end(), less);
+
+	//ȥزȥСkeyı߽磬
+	InternalKey smallest, largest;
+	GetRange2(c->inputs_[0], c->inputs_[1], &smallest, &largest);
+
+	std::vector<std::string> candidates;
+	for(size_t i = 0; i < bounds.size(); i++){
+		if(ucmp->Compare(bounds[i], smallest.user_key()) <= 0)
+			continue;
+		if(ucmp->Compare(bounds[i], largest.user_key()) > 0)
+			break;
+		if(candidates.empty() || ucmp->Compare(candidates.back(), bounds[i]) != 0)
+			candidates.push_back(bounds[i]);
+	}
+
+	if(candidates.empty())
+		return;
+
+	const int num_shards = std::min<int>(max_shards, candidates.size() + 1);
+	std::vector<std::string> splits;
+	for(int i = 1; i < num_shards; i++)
+		splits.push_back(candidates[i * candidates.size() / num_shards]);
+
+	for(int i = 0; i < num_shards; i ++){
+		Compaction* shard = new Compaction(c->level_);
+		shard->input_version_ = c->input_version_;
+		shard->input_version_->Ref();
+		shard->max_output_file_size_ = c->max_output_file_size_;
+
+		if(i > 0){
+			shard->has_shard_start_ = true;
+			shard->shard_start_ = splits[i - 1];
+		}
+		if(i + 1 < num_shards){
+			shard->has_shard_end_ = true;
+			shard->shard_end_ = splits[i];
+		}
+
+		//ֻصļ
+		for(int which = 0; which < 2; which ++){
+			for(size_t j = 0; j < c->inputs_[which].size(); j++){
+				FileMetaData* f = c->inputs_[which][j];
+				if(FileInShard(ucmp, f, shard->shard_start(), shard->shard_end()))
+					shard->inputs_[which].push_back(f);
+			}
+		}
+		for(size_t j = 0; j < c->grandparents_.size(); j++){
+			FileMetaData* f = c->grandparents_[j];
+			if(FileInShard(ucmp, f, shard->shard_start(), shard->shard_end()))
+				shard->grandparents_.push_back(f);
+		}
+
+		shards->push_back(shard);
+	}
 }
 
 Compaction::Compaction(int level) : level_(level), max_output_file_size_(MaxFileSizeForLevel(level)),
-	input_version_(NULL), grandparents_(0), seen_key_(false), overlapped_bytes_(0)
+	input_version_(NULL), grandparents_(0), seen_key_(false), overlapped_bytes_(0),
+	has_shard_start_(false), has_shard_end_(false)
 {
 	for(int i = 0; i < config::kNumLevels; i++)
 		level_ptrs_[i] = NULL;
@@ -1430,6 +1748,16 @@ bool Compaction::ShouldStopBefore(const Slice& internal_key)
 		return false;
 }
 
+void Compaction::MarkFilesBeingCompacted(bool mark)
+{
+	for(int which = 0; which < 2; which ++){
+		for(size_t i = 0; i < inputs_[which].size(); i++){
+			assert(inputs_[which][i]->being_compacted != mark);
+			inputs_[which][i]->being_compacted = mark;
+		}
+	}
+}
+
 void Compaction::ReleaseInputs()
 {
 	if(input_version_ != NULL){
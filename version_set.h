@@ -39,6 +39,9 @@ public:
 public:
 	void AddIterators(const ReadOptions& opt, std::vector<Iterator*>* iters);
 	Status Get(const ReadOptions& opt, const LookupKey& key, std::string* val, GetStats* stats);
+	//Getkeys밴user key*values[i]*statuses[i]Ϊkeys[i]Ľ
+	//statsֻ¼һҪļkey
+	void MultiGet(const ReadOptions& opt, const LookupKey* const* keys, int n, std::string** values, Status** statuses, GetStats* stats);
 	bool UpdateStats(const GetStats& stats);
 	
 	bool RecordReadSample(Slice key);
@@ -74,6 +77,8 @@ private:
 		file_to_compact_level_(-1),
 		compaction_score_(-1),
 		compaction_level_(-1) {
+		for(int i = 0; i < config::kNumLevels; i++)
+			compaction_scores_[i] = -1;
 	}
 
 	~Version();
@@ -96,6 +101,8 @@ private:
 
 	double compaction_score_;
 	int compaction_level_;
+	//compaction scoreCompactionʱscoreӸߵѡ
+	double compaction_scores_[config::kNumLevels];
 };
 
 class VersionSet
@@ -136,6 +143,8 @@ public:
 
 	Compaction* CompactRange(int level, const InternalKey* begin, const InternalKey* end);
 
+	void SplitCompaction(Compaction* c, int max_shards, std::vector<Compaction*>* shards);
+
 	int64_t MaxNextLevelOverlappingBytes();
 
 	Iterator* MakeInputIterator(Compaction* c);
@@ -171,7 +180,8 @@ private:
 	void GetRange2(const std::vector<FileMetaData*>& inputs1,  const std::vector<FileMetaData*>& inputs2,
 		InternalKey* smallest, InternalKey* largest);
 
-	void SetupOtherInputs(Compaction* c);
+	bool SetupOtherInputs(Compaction* c);
+	Compaction* PickCompactionAtLevel(int level);
 	Status WriteSnapshot(log::Writer* log);
 
 	void AppendVersion(Version* v);
@@ -222,6 +232,13 @@ public:
 
 	void ReleaseInputs();
 
+	//ǻļbeing_compacted,ReleaseInputs֮ǰ
+	void MarkFilesBeingCompacted(bool mark);
+
+	//compactionuser key[shard_start, shard_end)NULLʾ
+	const std::string* shard_start() const { return has_shard_start_ ? &shard_start_ : NULL; }
+	const std::string* shard_end() const { return has_shard_end_ ? &shard_end_ : NULL; }
+
 private:
 	friend class Version;
 	friend class VersionSet;
@@ -241,6 +258,11 @@ private:
 	int64_t overlapped_bytes_;
 
 	size_t level_ptrs_[config::kNumLevels];
+
+	bool has_shard_start_;
+	std::string shard_start_;
+	bool has_shard_end_;
+	std::string shard_end_;
 };
 
 };//leveldb
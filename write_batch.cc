@@ -112,26 +112,28 @@ class MemTableInserter : public WriteBatch::Handler
 public:
 	SequenceNumber sequence_; //ţ
 	MemTable* mem_; //memtable
+	bool concurrent_; //Ƿ̲߳
 
 	virtual void Put(const Slice& key, const Slice& value)
 	{
-		mem_->Add(sequence_, kTypeValue, key, value);
+		mem_->Add(sequence_, kTypeValue, key, value, concurrent_);
 		sequence_ ++;
 	}
 
 	virtual void Delete(const Slice& key)
 	{
-		mem_->Add(sequence_, kTypeDeletion, key, Slice());
+		mem_->Add(sequence_, kTypeDeletion, key, Slice(), concurrent_);
 		sequence_ ++;
 	}
 };
 };
 
-Status WriteBatchInternal::InsertInto(const WriteBatch* b, MemTable* memtable)
+Status WriteBatchInternal::InsertInto(const WriteBatch* b, MemTable* memtable, bool concurrent)
 {
 	MemTableInserter inserter;
 	inserter.sequence_ = WriteBatchInternal::Sequence(b);
 	inserter.mem_ = memtable;
+	inserter.concurrent_ = concurrent;
 	return b->Iterate(&inserter);
 }
 
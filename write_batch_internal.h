@@ -29,7 +29,8 @@ public:
 
 	static void SetContents(WriteBatch* batch, const Slice& contents);
 
-	static Status InsertInto(const WriteBatch* batch, MemTable* memtable);
+	//concurrentΪtrueʱ߳ͬʱͬһmemtable
+	static Status InsertInto(const WriteBatch* batch, MemTable* memtable, bool concurrent = false);
 
 	static void Append(WriteBatch* dst, const WriteBatch* src);
 };